@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include "MBIEffect.h"
+
+// One period of a deterministic effect, captured on a PC by tools/bake.cpp (tables are in BakedTables.h). Stored as
+// the first frame, then the per-frame change of every LED, run length encoded: consecutive frames that change the same
+// way share a run. The changes in a table only take a handful of distinct values (a chase ramps everything by the same
+// step), so each is stored as a 4-bit index into a palette.
+//
+// Each run is a 16-bit little endian frame count, then (n_leds + 1) / 2 bytes of palette indices, low nibble first.
+// The changes wrap around like the effect's own uint16_t arithmetic did.
+struct BakedTable {
+    uint8_t n_leds;
+    const uint16_t* first;
+    const int16_t* palette; // up to 16 entries
+    const uint8_t* runs;
+    uint16_t n_runs;
+};
+
+// Play back a baked table. Replaces the effect's arithmetic with one add per LED, and unpacking a run now and then.
+// Tables are baked at 16 bits and played back at 16 bits, frames are only cut down to the driver's pixel depth on the
+// way out. A table baked for a different number of LEDs can't be decoded, it plays dark.
+template <class MBI> struct Baked : MBIEffect<MBI> {
+    Baked(const BakedTable& table)
+        : _table(table)
+        , _valid(table.n_leds == MBI::N_LEDS) // only checked at run time, tables are plain arrays
+    {
+        if (_valid)
+            std::copy(table.first, table.first + MBI::N_LEDS, _frame.begin());
+    }
+
+    void operator()(MBI& mbi, const uint32_t)
+    {
+        from16<MBI>(mbi.get_buffer(), _frame);
+        if (!_valid)
+            return;
+
+        // On to the frame after the ones this call covers, a multiply-add per LED per run crossed
+        for (uint16_t n = this->frames_per_call(); n;) {
+            if (!_left)
+                next_run();
+            uint16_t k = std::min(n, _left);
+            for (auto i = 0U; i < MBI::N_LEDS; i++)
+                _frame[i] += _delta[i] * k;
+            _left -= k;
+            n -= k;
+        }
+    }
+
+private:
+    static constexpr auto RUN_BYTES = 2 + (MBI::N_LEDS + 1) / 2;
+
+    void next_run()
+    {
+        if (_run == _table.n_runs)
+            _run = 0; // back to the start of the period, _frame has arrived back at the first frame
+        auto r = _table.runs + _run++ * RUN_BYTES;
+        _left = r[0] | r[1] << 8;
+        for (auto i = 0U; i < MBI::N_LEDS; i++)
+            _delta[i] = _table.palette[(r[2 + i / 2] >> (i & 1 ? 4 : 0)) & 0xf];
+    }
+
+    const BakedTable& _table;
+    const bool _valid;
+    std::array<uint16_t, MBI::N_LEDS> _frame {};
+    std::array<int16_t, MBI::N_LEDS> _delta {};
+    uint16_t _run = 0, _left = 0;
+};
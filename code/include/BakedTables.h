@@ -0,0 +1,86 @@
+#pragma once
+
+// Generated by tools/bake.cpp, don't edit. To regenerate, from the code/ directory:
+//   ./bake > include/BakedTables.h
+
+#include <cstdint>
+
+#include "Baked.h"
+
+namespace baked {
+
+// ChaseAround: 1680 frame period in 15 runs, 188 bytes
+constexpr uint16_t ChaseAround_first[] = {
+    0, 0, 0, 0, 0, 0, 0, 18746, 40586, 62426, 9282,
+};
+constexpr int16_t ChaseAround_palette[] = {
+    0, -182, 546,
+};
+constexpr uint8_t ChaseAround_runs[] = {
+    103, 0, 0, 0, 0, 16, 17, 2, 120, 0, 32, 0, 0, 0, 17, 1,
+    120, 0, 18, 0, 0, 0, 16, 1, 120, 0, 17, 2, 0, 0, 0, 1,
+    120, 0, 17, 1, 0, 0, 2, 0, 120, 0, 1, 1, 0, 0, 33, 0,
+    120, 0, 0, 1, 0, 0, 17, 2, 120, 0, 0, 32, 0, 0, 17, 1,
+    120, 0, 0, 16, 2, 0, 16, 1, 120, 0, 0, 16, 33, 0, 0, 1,
+    120, 0, 0, 16, 17, 2, 0, 0, 120, 0, 0, 0, 17, 33, 0, 0,
+    120, 0, 0, 0, 16, 17, 2, 0, 120, 0, 0, 0, 0, 17, 33, 0,
+    17, 0, 0, 0, 0, 16, 17, 2,
+};
+constexpr BakedTable ChaseAround = { 11, ChaseAround_first, ChaseAround_palette, ChaseAround_runs, 15 };
+
+// ChaseBack: 210 frame period in 27 runs, 288 bytes
+constexpr uint16_t ChaseBack_first[] = {
+    40891, 46846, 34936, 11116, 5161, 0, 0, 8734, 64741, 58786, 52831,
+};
+constexpr int16_t ChaseBack_palette[] = {
+    -397, 0, 4367, 2382, 3573,
+};
+constexpr uint8_t ChaseBack_runs[] = {
+    13, 0, 0, 0, 16, 33, 0, 0, 15, 0, 0, 0, 17, 2, 0, 0,
+    15, 0, 0, 16, 33, 0, 0, 0, 15, 0, 0, 16, 2, 0, 0, 0,
+    15, 0, 0, 32, 0, 0, 0, 0, 9, 0, 0, 0, 0, 0, 0, 2,
+    1, 0, 0, 0, 0, 0, 0, 3, 5, 0, 0, 0, 0, 0, 0, 1,
+    9, 0, 0, 1, 0, 0, 32, 0, 1, 0, 0, 1, 0, 0, 48, 0,
+    5, 0, 0, 1, 0, 0, 16, 0, 9, 0, 1, 1, 0, 0, 2, 0,
+    1, 0, 1, 1, 0, 0, 3, 0, 5, 0, 1, 1, 0, 0, 1, 0,
+    15, 0, 17, 2, 0, 0, 0, 0, 15, 0, 18, 0, 0, 0, 0, 0,
+    15, 0, 32, 0, 0, 0, 0, 0, 6, 0, 0, 0, 0, 0, 0, 2,
+    1, 0, 0, 0, 0, 0, 0, 4, 8, 0, 0, 0, 0, 0, 0, 1,
+    6, 0, 0, 0, 0, 16, 32, 0, 1, 0, 0, 0, 0, 16, 64, 0,
+    8, 0, 0, 0, 0, 16, 16, 0, 6, 0, 0, 0, 0, 17, 2, 0,
+    1, 0, 0, 0, 0, 17, 4, 0, 8, 0, 0, 0, 0, 17, 1, 0,
+    2, 0, 0, 0, 16, 33, 0, 0,
+};
+constexpr BakedTable ChaseBack = { 11, ChaseBack_first, ChaseBack_palette, ChaseBack_runs, 27 };
+
+// FastChase: 70 frame period in 15 runs, 188 bytes
+constexpr uint16_t FastChase_first[] = {
+    39321, 26214, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+constexpr int16_t FastChase_palette[] = {
+    -13107, 13107, 0,
+};
+constexpr uint8_t FastChase_runs[] = {
+    3, 0, 16, 34, 34, 34, 34, 2, 5, 0, 2, 34, 34, 34, 34, 1,
+    5, 0, 34, 34, 34, 34, 18, 0, 5, 0, 34, 34, 34, 34, 1, 2,
+    5, 0, 34, 34, 34, 18, 32, 2, 5, 0, 34, 34, 34, 1, 34, 2,
+    5, 0, 34, 34, 18, 32, 34, 2, 5, 0, 34, 34, 1, 34, 34, 2,
+    5, 0, 34, 18, 32, 34, 34, 2, 5, 0, 34, 2, 34, 34, 34, 1,
+    5, 0, 34, 34, 34, 34, 18, 0, 5, 0, 34, 34, 34, 34, 1, 2,
+    5, 0, 34, 33, 34, 34, 32, 2, 5, 0, 33, 32, 34, 34, 34, 2,
+    2, 0, 16, 34, 34, 34, 34, 2,
+};
+constexpr BakedTable FastChase = { 11, FastChase_first, FastChase_palette, FastChase_runs, 15 };
+
+// RampAllUp: 65536 frame period in 2 runs, 80 bytes
+constexpr uint16_t RampAllUp_first[] = {
+    61951, 61951, 61951, 61951, 61951, 61951, 61951, 61951, 61951, 61951, 61951,
+};
+constexpr int16_t RampAllUp_palette[] = {
+    511,
+};
+constexpr uint8_t RampAllUp_runs[] = {
+    255, 255, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0,
+};
+constexpr BakedTable RampAllUp = { 11, RampAllUp_first, RampAllUp_palette, RampAllUp_runs, 2 };
+}
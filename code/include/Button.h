@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "config.h"
+
+// Press duration state machine for the power/mode button. It is fed debounced level changes with timestamps in frames
+// (from the EXTI/debounce timer interrupts on target) and publishes short, long and power presses to the main loop
+// through a small queue, so presses are timed correctly no matter how often the main loop looks.
+//
+// Long presses are > LONG_PRESS & < PWR_PRESS, power presses are >= PWR_PRESS. All are reported on release.
+struct Button {
+    enum event_t : uint8_t { NONE, SHORT, LONG, POWER };
+
+    // The button is usually held to wake us up, so ignore whatever press is in progress at power up
+    void start(const bool pressed)
+    {
+        _pressed = pressed;
+        _ignore = pressed;
+    }
+
+    // A debounced level change at frame `now`. Repeats of the current level are ignored.
+    void edge(const bool pressed, const uint32_t now)
+    {
+        if (pressed == _pressed)
+            return;
+        _pressed = pressed;
+        last_activity = now;
+
+        if (pressed) {
+            _press_start = now;
+        } else if (_ignore) {
+            _ignore = false;
+        } else {
+            auto held = now - _press_start;
+            push(held >= PWR_PRESS ? POWER : held > LONG_PRESS ? LONG : SHORT);
+        }
+    }
+
+    // How long the current press has been going at frame `now`, 0 if not pressed (or ignored)
+    uint32_t held(const uint32_t now) const { return _pressed && !_ignore ? now - _press_start : 0; }
+
+    // Next event, or NONE
+    event_t pop()
+    {
+        if (_head == _tail)
+            return NONE;
+        auto e = _queue[_tail];
+        _tail = (_tail + 1) % _queue.size();
+        return e;
+    }
+
+    // Frame of the last press or release, for auto power off
+    volatile uint32_t last_activity = 0;
+
+private:
+    // Queue is written from interrupt context and read from the main loop, one each
+    void push(const event_t e)
+    {
+        uint8_t next = (_head + 1) % _queue.size();
+        if (next == _tail)
+            return; // Full, the main loop isn't keeping up anyway
+        _queue[_head] = e;
+        _head = next;
+    }
+
+    std::array<event_t, 4> _queue {};
+    volatile uint8_t _head = 0, _tail = 0;
+
+    volatile bool _pressed = false;
+    bool _ignore = false;
+    volatile uint32_t _press_start = 0;
+};
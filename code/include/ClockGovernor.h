@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "config.h"
+
+// Run the core as slowly as each effect allows. The cost of every frame (effect render + output) is measured in
+// cycles, which don't change much with the clock, and each effect keeps a slowly decaying peak of its cost. The governor
+// picks the biggest SYSCLK divider whose frame budget still covers that peak with CLOCK_MARGIN_PCT to spare.
+//
+// Work done per frame takes the same number of cycles at any clock, so the saving comes from the time spent asleep
+// between frames, where the current scales with the clock.
+template <uint8_t n_slots> struct ClockGovernor {
+    // Dividers to choose from, up to CLK_DIV_MAX (below that GCLK can't fit a PWM cycle in a frame)
+    static constexpr std::array<uint8_t, 2> DIVS = { 1, 2 };
+    static_assert(DIVS.back() <= CLK_DIV_MAX, "GCLK can't keep up with the core divided further than CLK_DIV_MAX");
+
+    // Peaks decay by 1/2^n per frame, so a spike is forgotten over a few multiples of 2^n frames
+    static constexpr uint8_t DECAY_SHIFT = 6;
+
+    // Extra margin needed before slowing down, so we don't flap on a boundary
+    static constexpr uint32_t SLOWDOWN_MARGIN_PCT = 25;
+
+    // Cycles available for one frame at a given divider
+    static constexpr uint32_t budget(const uint8_t div) { return F_CPU / div / FPS; }
+
+    static constexpr bool fits(const uint32_t cycles, const uint8_t div, const uint32_t margin_pct)
+    {
+        return cycles + cycles * margin_pct / 100 <= budget(div);
+    }
+
+    // Estimated MCU current saved by running at F_CPU / div rather than F_CPU
+    static constexpr uint32_t saving_ua(const uint8_t div)
+    {
+        return (F_CPU - F_CPU / div) / 1000 * MCU_SLEEP_UA_PER_MHZ / 1000;
+    }
+
+    ClockGovernor() { peak.fill(budget(DIVS[0])); } // Unknown effects start out assumed to need full speed
+
+    // Record the cost of a frame drawn by effect `slot`, returns the divider to run at
+    uint8_t update(const uint8_t slot, const uint32_t cycles)
+    {
+        auto& p = peak[slot];
+        p -= p >> DECAY_SHIFT;
+        if (cycles > p)
+            p = cycles;
+
+        // Speed up immediately if we're over budget...
+        while (idx > 0 && !fits(p, DIVS[idx], CLOCK_MARGIN_PCT))
+            idx--;
+        // ...but only slow down with some extra headroom
+        while (idx + 1U < DIVS.size() && fits(p, DIVS[idx + 1], CLOCK_MARGIN_PCT + SLOWDOWN_MARGIN_PCT))
+            idx++;
+
+        chosen[slot] = DIVS[idx];
+        return DIVS[idx];
+    }
+
+    uint8_t div() const { return DIVS[idx]; }
+
+    // Decaying peak frame cost, and the divider last chosen, per slot
+    std::array<uint32_t, n_slots> peak;
+    std::array<uint8_t, n_slots> chosen {};
+    uint8_t idx = 0;
+};
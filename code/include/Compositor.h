@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "MBIEffect.h"
+#include "Packed.h"
+
+// Stack several effects, e.g. a menu indicator over the running animation. Each layer's effect draws into its own
+// buffer (the driver's get_buffer() is pointed at it), so effects that build on their last frame carry on undisturbed,
+// then the layers are blended bottom up into the real frame buffer.
+//
+// Costs a frame buffer of RAM per layer, 24 bytes for 11 LEDs (12 with 8-bit pixels).
+template <class MBI, uint8_t n_layers> struct Compositor : MBIEffect<MBI> {
+    enum blend_t : uint8_t {
+        ADD, // saturating
+        MAX,
+        MULTIPLY, // layer below scaled by this one, e.g. a mask
+        ALPHA, // this layer over the one below with opacity alpha/256
+    };
+
+    // Put `effect` on layer i (0 is the bottom, its mode is ignored), nullptr to clear it
+    void set(const uint8_t i, MBIEffect<MBI>* effect, const blend_t mode = MAX, const uint16_t alpha = 256)
+    {
+        _layers[i].effect = effect;
+        _layers[i].mode = mode;
+        _layers[i].alpha = alpha;
+    }
+
+    // Start layer i's buffer from `fb`, so an effect moved onto a layer carries on from where it was
+    void seed(const uint8_t i, const typename MBI::fb_t& fb) { _layers[i].fb = fb; }
+
+    void operator()(MBI& mbi, const uint32_t frames)
+    {
+        auto& out = mbi.get_buffer();
+        for (auto& l : _layers) {
+            if (!l.effect)
+                continue;
+            auto prev = mbi.draw_to(&l.fb);
+            // Every layer is drawn at the rate of the fastest
+            l.effect->frame_shift = this->frame_shift;
+            (*l.effect)(mbi, frames);
+            mbi.draw_to(prev);
+        }
+
+        using T = typename MBI::pixel_t;
+        out = _layers[0].fb;
+        for (auto i = 1U; i < n_layers; i++) {
+            auto& l = _layers[i];
+            if (!l.effect)
+                continue;
+            switch (l.mode) {
+            case ADD:
+                packed::apply(out, l.fb, packed::add_sat<T>);
+                break;
+            case MAX:
+                packed::apply(out, l.fb, packed::max<T>);
+                break;
+            case MULTIPLY:
+                packed::apply(out, l.fb, packed::mul<T>);
+                break;
+            case ALPHA:
+                packed::apply(out, l.fb, [&l](uint32_t a, uint32_t b) { return packed::lerp<T>(a, b, l.alpha); });
+                break;
+            }
+        }
+    }
+
+    // Fast enough for the fastest layer
+    uint8_t keyframe_shift() const
+    {
+        uint8_t shift = UINT8_MAX;
+        for (auto& l : _layers)
+            if (l.effect)
+                shift = std::min(shift, l.effect->keyframe_shift());
+        return shift == UINT8_MAX ? 0 : shift;
+    }
+
+private:
+    struct layer_t {
+        alignas(4) typename MBI::fb_t fb {};
+        MBIEffect<MBI>* effect = nullptr;
+        blend_t mode = MAX;
+        uint16_t alpha = 256;
+    };
+
+    std::array<layer_t, n_layers> _layers;
+};
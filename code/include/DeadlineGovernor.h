@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "config.h"
+#include "util.h"
+
+// Degrade quality in steps when the effect can't keep up with the frame rate, rather than silently dropping frames.
+// SysTick reports every tick (late() if a keyframe was due but the main loop hadn't finished drawing it), and the main
+// loop escalates when lateness persists:
+//   1. NO_GAMMA: the frames output while the main loop catches up skip the gamma curve, which is most of the output
+//      stage's cost with 16-bit pixels, and would otherwise be taken from the effect's time
+//   2. HALF_RATE: the effect's keyframe rate is halved, up to DEADLINE_MAX_SHIFT times
+//   3. SWITCH: at the lowest rate and still late, the main loop moves on to the next effect
+// The keyframe rate comes back up a step at a time after DEADLINE_RECOVER_FRAMES on time. Each step taken is counted,
+// for the debug reports.
+struct DeadlineGovernor {
+    enum step_t : uint8_t { NO_GAMMA, HALF_RATE, SWITCH, N_STEPS };
+
+    // From SysTick, every tick. `key_shift` is the keyframe rate being output.
+    void tick(const bool late, const uint8_t key_shift)
+    {
+        if (!late)
+            return;
+        late_ticks++;
+        if (!no_gamma)
+            events[NO_GAMMA]++;
+        // Until the next keyframe has been interpolated to
+        no_gamma = 1 << key_shift;
+    }
+
+    // From SysTick, for each frame it outputs: whether to skip the gamma curve this time
+    bool skip_gamma()
+    {
+        if (!no_gamma)
+            return false;
+        no_gamma--;
+        return true;
+    }
+
+    // From the main loop, once per pass. Returns true if the effect should be switched, which is only counted if
+    // `can_switch` (the menus hold on to the effect).
+    bool update(const uint32_t frame, const bool can_switch = true)
+    {
+        now = frame;
+        uint32_t late = late_ticks - seen_ticks;
+        seen_ticks += late;
+        if (late) {
+            window_late += late;
+            on_time_since = frame;
+        }
+
+        if (window_late >= DEADLINE_LATE_LIMIT) {
+            window_late = 0;
+            window_start = frame;
+            if (shift < DEADLINE_MAX_SHIFT) {
+                shift++;
+                events[HALF_RATE]++;
+                return false;
+            }
+            events[SWITCH] += can_switch;
+            return can_switch;
+        }
+
+        // Lateness only counts towards the next step for a while
+        if (frame_reached(frame, window_start + DEADLINE_WINDOW_FRAMES)) {
+            window_late = 0;
+            window_start = frame;
+        }
+        if (shift && frame_reached(frame, on_time_since + DEADLINE_RECOVER_FRAMES)) {
+            shift--;
+            on_time_since = frame;
+        }
+        return false;
+    }
+
+    // A new effect starts at its own rate, with a clean slate: its lateness window and its wait to recover start from the
+    // last pass
+    void reset()
+    {
+        shift = 0;
+        window_late = 0;
+        window_start = now;
+        on_time_since = now;
+        seen_ticks = late_ticks;
+    }
+
+    // Keyframe shift to add to the effect's own
+    uint8_t shift = 0;
+
+    // Steps taken since power on
+    std::array<uint32_t, N_STEPS> events {};
+
+    // Ticks that found the main loop late, written by SysTick only
+    volatile uint32_t late_ticks = 0;
+
+private:
+    volatile uint16_t no_gamma = 0;
+
+    uint32_t seen_ticks = 0;
+    uint32_t window_late = 0;
+    uint32_t window_start = 0;
+    uint32_t on_time_since = 0;
+    // Frame of the last pass
+    uint32_t now = 0;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// First-order sigma-delta quantizer, applied over time (frames) instead of space. The corrected output is computed with
+// frac_bits of extra precision below the output LSB; the part that doesn't fit in the output code is carried to the
+// same LED's next frame, so the time-averaged output tracks the exact corrected value instead of always truncating
+// down. At low brightness settings this turns the handful of output codes slow fades collapse onto into a smooth
+// average. Integer-only, a couple of cycles per LED.
+template <uint8_t n_leds, uint8_t frac_bits = 8> struct SigmaDelta {
+    static_assert(frac_bits > 0 && frac_bits <= 8, "Error accumulator is a uint8_t");
+
+    static constexpr auto FRAC_BITS = frac_bits;
+    static constexpr uint32_t FRAC_MASK = (1U << frac_bits) - 1;
+
+    // Quantize `fine` (output value << frac_bits) for LED `led`, carrying the remainder to the next call for that LED
+    uint16_t operator()(const uint8_t led, const uint32_t fine)
+    {
+        if (fine == 0) {
+            // Off is off, and doesn't leave stale error to flash the LED on the next frame
+            err[led] = 0;
+            return 0;
+        }
+        uint32_t acc = fine + err[led];
+        err[led] = acc & FRAC_MASK;
+        acc >>= frac_bits;
+        return acc > UINT16_MAX ? UINT16_MAX : acc;
+    }
+
+    void reset() { err.fill(0); }
+
+    std::array<uint8_t, n_leds> err {};
+};
@@ -1,9 +1,24 @@
 #pragma once
 
+#include "Baked.h"
+#include "BakedTables.h"
+#include "Compositor.h"
 #include "Effects.h"
+#include "Noise.h"
+#include "Script.h"
+#include "Scripts.h"
+#include "Spatial.h"
+#include "Waveforms.h"
 #include "config.h"
 
-using mbi_t = MBI5043<11, MBI_GCLK_TIMER, MBI_GCLK_TIMER_RCC>;
+#if defined(STM32F0) || defined(STM32F1)
+#include "MBI5043.h"
+using mbi_t = MBI5043<11, MBI_GCLK_TIMER, MBI_GCLK_TIMER_RCC, fb_pixel_t>;
+#else
+// Native (unit test) builds run the same effects through the output stage without the driver
+#include "OutputStage.h"
+using mbi_t = OutputStage<11, fb_pixel_t>;
+#endif
 using effect_fb_t = mbi_t::fb_t&;
 using effect_ref = std::reference_wrapper<MBIEffect<mbi_t>>;
 
@@ -29,7 +44,57 @@ auto RandomSequence = RandomChase<mbi_t>(5, 1, 0);
 
 auto RampAllUp = RampAll<mbi_t>(mbi_t::LED_MAX / 128);
 
-auto TwinkleTwinkle = Twinkle<mbi_t>(8192, 40);
-auto TwinkleBlinkle = Twinkle<mbi_t>(INT16_MAX / 2, 20);
+// Deterministic effects played back from tables baked by tools/bake.cpp from the instances above (regenerate the tables
+// after changing their parameters). Always start from the same point of the period, unlike the originals.
+auto BakedChaseAround = Baked<mbi_t>(baked::ChaseAround);
+auto BakedChaseBack = Baked<mbi_t>(baked::ChaseBack);
+auto BakedFastChase = Baked<mbi_t>(baked::FastChase);
 
-auto indicator = FirstN<mbi_t>(1, true);
\ No newline at end of file
+// Effects written as scripts (scripts/*.anim, compiled into Scripts.h by tools/animc.cpp)
+auto ScriptBreathe = Script<mbi_t>(scripts::breathe);
+auto ScriptComet = Script<mbi_t>(scripts::comet);
+auto ScriptHeartbeat = Script<mbi_t>(scripts::heartbeat);
+auto ScriptSparkle = Script<mbi_t>(scripts::sparkle);
+auto ScriptWipe = Script<mbi_t>(scripts::wipe);
+
+// Effects that work from where the LEDs are (Geometry.h)
+auto RadialPulse = Wave<mbi_t>(geometry::DIST, FPS * 2); // rings out from the middle
+auto Lighthouse = Wave<mbi_t>(geometry::ANGLE, FPS * 3); // a beam sweeping round
+auto FallingBands = Wave<mbi_t>(geometry::Y, FPS * 2, 2);
+auto Bursts = StarBurst<mbi_t>(FPS, mbi_t::LED_MAX / 8, mbi_t::LED_MAX / 64, mbi_t::LED_MAX / 4);
+
+// Smooth curves (Fixed.h)
+auto Breathing = Breathe<mbi_t>(FPS * 4);
+auto PlasmaField = Plasma<mbi_t>(FPS * 5, -FPS * 7);
+auto SineChaseAround
+    = SineChase<mbi_t, decltype(LED_ORDER)::const_iterator>(LED_ORDER.begin(), LED_ORDER.end(), FPS * 2);
+
+auto TwinkleTwinkle = Twinkle<mbi_t>((mbi_t::LED_MAX + 1) / 8, 40, 2); // 15Hz keyframes
+auto TwinkleBlinkle = Twinkle<mbi_t>(mbi_t::LED_MAX / 4, 20, 1); // 30Hz keyframes
+
+// The same, following value noise (Noise.h): no per-LED targets or RNG draws
+auto NoiseTwinkleTwinkle = NoiseTwinkle<mbi_t>((mbi_t::LED_MAX + 1) / 8, 40, 2);
+auto NoiseTwinkleBlinkle = NoiseTwinkle<mbi_t>(mbi_t::LED_MAX / 4, 20, 1);
+
+auto indicator = FirstN<mbi_t>(1, true);
+
+auto streamed = External<mbi_t>();
+
+// Menu feedback drawn over the running effect
+using overlay_t = Compositor<mbi_t, 2>;
+auto overlay = overlay_t();
+
+// Enabled effects, in the order the button steps through them. Here rather than in main.cpp so host tools can run
+// the same lineup (e.g. tools/montecarlo.cpp).
+const std::array<effect_ref, 10> effects = {
+    TwinkleBlinkle,
+    RandomSequence,
+    ChaseRandom,
+    TwinkleTwinkle,
+    BakedChaseAround,
+    ScriptComet,
+    ScriptSparkle,
+    RadialPulse,
+    Bursts,
+    PlasmaField,
+};
@@ -5,6 +5,7 @@
 #include <utility>
 
 #include "MBIEffect.h"
+#include "Packed.h"
 
 // EFFECTS
 
@@ -29,7 +30,7 @@ struct AllRandomRange : MBIEffect<MBI> {
     }
 };
 
-// Ramp continuously by step_size
+// Ramp continuously by step_size a frame
 template <class MBI> struct RampAll : MBIEffect<MBI> {
     uint16_t step_size;
     RampAll(uint16_t _step_size)
@@ -38,9 +39,9 @@ template <class MBI> struct RampAll : MBIEffect<MBI> {
     }
     void operator()(MBI& mbi, const uint32_t)
     {
-        std::transform(
-            mbi.get_buffer().begin(), mbi.get_buffer().end(),
-            mbi.get_buffer().begin(), [this](auto val) -> auto { return val + step_size; });
+        using T = typename MBI::pixel_t;
+        T step = step_size << this->frame_shift;
+        packed::apply(mbi.get_buffer(), [s = packed::splat<T>(step)](uint32_t v) { return packed::add<T>(v, s); });
     }
 };
 
@@ -62,7 +63,8 @@ template <class MBI, class Iter> struct Chase : MBIEffect<MBI> {
     {
         pos = last;
         frames_left = speed;
-        step_size = (MBI::LED_MAX - MBI::LED_MIN) / (speed * length);
+        // At least 1, slow chases are too fine for 8-bit pixels
+        step_size = std::max(1, (MBI::LED_MAX - MBI::LED_MIN) / (speed * length));
     }
     void operator()(MBI& mbi, const uint32_t)
     {
@@ -71,7 +73,7 @@ template <class MBI, class Iter> struct Chase : MBIEffect<MBI> {
         // RNG will be initialized by now, so on the first loop we choose a random start position
         if (pos == last)
             pos = first + std::uniform_int_distribution<uint8_t>(0, last - first - 1)(effect_rng);
-        if (!frames_left) {
+        if (frames_left <= 0) {
             if (_dir == UP) {
                 pos++;
                 if (pos == last)
@@ -81,43 +83,41 @@ template <class MBI, class Iter> struct Chase : MBIEffect<MBI> {
                     pos = last;
                 pos--;
             }
-            frames_left = _speed;
+            frames_left += _speed;
         }
 
-        // Loop the output buffer checking whether we should (without overflowing) decrement or increment
-        for (auto i = 0U; i < fb.size(); i++) {
-            if (i != *pos) {
-                // Ramp down the long tail
-                // fb[i] -= std::min<uint16_t>(step_size, fb[i]);
-                fb[i] = sat_sub(fb[i], step_size);
-            } else {
-                // Ramp up the 'target' LED _length times as fast
-                // fb[i] += std::min<uint16_t>(step_size * _length, MBI::LED_MAX - fb[i]);
-                fb[i] = sat_add(fb[i], step_size * _length);
-            }
-        }
-        frames_left--;
+        // Ramp up the 'target' LED _length times as fast as the long tail ramps down (without overflowing). The tail is
+        // done two LEDs at a time over the whole buffer, then the target put back. Called less often than every frame,
+        // each call does the steps of the frames it covers; the LED moves on at the first call past _speed frames.
+        using T = typename MBI::pixel_t;
+        uint32_t step = std::min<uint32_t>(step_size << this->frame_shift, MBI::LED_MAX);
+        T target = std::min<uint32_t>(fb[*pos] + step * _length, MBI::LED_MAX);
+        packed::apply(fb, [s = packed::splat<T>(step)](uint32_t v) { return packed::sub_sat<T>(v, s); });
+        fb[*pos] = target;
+        frames_left -= this->frames_per_call();
     }
 
 private:
     Iter first, last, pos; // Changing these on the fly will break stuff
-    uint16_t frames_left, step_size;
+    int16_t frames_left;
+    uint16_t step_size;
     uint16_t _speed, _length;
 };
 
-// This and the ordered chase can probably be refactored into one class...
-template <class MBI> struct RandomChase : MBIEffect<MBI> {
+// This and the ordered chase can probably be refactored into one class... word_t is the type the step is worked out
+// in, for counting (OpCount.h); the packed pass over the frame isn't counted.
+template <class MBI, class word_t = uint32_t> struct RandomChase : MBIEffect<MBI> {
 
     // Speed is the number of frames to fade up the target LED before moving on.
     // Length is the number of LEDs in the 'tail' that are fading down.
-    RandomChase(uint16_t speed = 20, uint16_t length = 4, uint16_t min_val = 16384)
+    RandomChase(uint16_t speed = 20, uint16_t length = 4, uint16_t min_val = (MBI::LED_MAX + 1) / 4)
         : _min_val(min_val)
         , _speed(speed)
         , _length(length)
     {
         pos = pos_map.begin();
         frames_left = speed;
-        step_size = (MBI::LED_MAX - min_val) / (speed * length);
+        step_size = std::max(1, (MBI::LED_MAX - min_val) / (speed * length));
 
         // Start with an ordered sequence 0 - N_LEDS-1
         std::iota(pos_map.begin(), pos_map.end(), 0);
@@ -129,41 +129,42 @@ template <class MBI> struct RandomChase : MBIEffect<MBI> {
     {
         auto& fb = mbi.get_buffer();
 
-        if (!frames_left) {
+        if (frames_left <= 0) {
             pos++;
             if (pos == pos_map.end()) {
                 new_posmap();
                 pos = pos_map.begin();
             }
-            frames_left = _speed;
+            frames_left += _speed;
         }
 
-        // Loop the output buffer checking whether we should (without overflowing) decrement or increment
-        for (auto i = 0U; i < fb.size(); i++) {
-            if (i != *pos) {
-                // Ramp down the long tail
-                // fb[i] -= std::min<uint16_t>(step_size, fb[i]);
-                fb[i] = std::max(_min_val, sat_sub(fb[i], step_size));
-            } else {
-                // Ramp up the 'target' LED _length times as fast
-                // fb[i] += std::min<uint16_t>(step_size * _length, MBI::LED_MAX - fb[i]);
-                fb[i] = sat_add(fb[i], step_size * _length);
-            }
-        }
-        frames_left--;
+        // As Chase, but the tail doesn't go below _min_val
+        using T = typename MBI::pixel_t;
+        word_t step = std::min<word_t>(word_t(step_size) << this->frame_shift, MBI::LED_MAX);
+        T target = static_cast<T>(std::min<word_t>(fb[*pos] + step * _length, MBI::LED_MAX));
+        packed::apply(fb, [s = packed::splat<T>(static_cast<T>(step)), m = packed::splat<T>(_min_val)](uint32_t v) {
+            return packed::max<T>(packed::sub_sat<T>(v, s), m);
+        });
+        fb[*pos] = target;
+        frames_left -= this->frames_per_call();
     }
 
 private:
     void new_posmap() { std::shuffle(pos_map.begin(), pos_map.end(), effect_rng); }
     std::array<uint8_t, MBI::N_LEDS> pos_map;
     typename decltype(pos_map)::const_iterator pos;
-    uint16_t frames_left, step_size, _min_val;
+    int16_t frames_left;
+    uint16_t step_size, _min_val;
     uint16_t _speed, _length;
 };
 
-template <class MBI> struct Twinkle : MBIEffect<MBI> {
+// A division per LED per call, done in word_t (counted in test_OPCOUNT)
+template <class MBI, class word_t = int32_t> struct Twinkle : MBIEffect<MBI> {
 
-    Twinkle(int16_t magnitude, uint16_t speed)
+    // Targets are at least 10 frames apart, so this can render at a lower keyframe rate without losing much. Magnitude
+    // is in the driver's units, at most LED_MAX / 2.
+    Twinkle(int16_t magnitude, uint16_t speed, uint8_t keyframe_shift = 0)
+        : _keyframe_shift(keyframe_shift)
     {
         val_gen = std::uniform_int_distribution<int16_t>(-magnitude, magnitude);
         frame_gen = std::uniform_int_distribution<uint16_t>(10, speed);
@@ -183,12 +184,16 @@ template <class MBI> struct Twinkle : MBIEffect<MBI> {
                 fb[i] = t_v;
                 targets[i] = make_target(frame);
             } else {
-                fb[i] = sat_ofs(fb[i],
-                    (t_v - fb[i]) / static_cast<int32_t>(t_f - frame)); // Add the distance to go over frames to go
+                // Add the distance to go over the calls left to get there (rounded up, the last one lands on or past
+                // t_f). Never overshoots the target, so doesn't need saturating.
+                word_t calls = (word_t(t_f) - frame + this->frames_per_call() - 1) >> this->frame_shift;
+                fb[i] = static_cast<typename MBI::pixel_t>(fb[i] + (word_t(t_v) - fb[i]) / calls);
             }
         }
     }
 
+    uint8_t keyframe_shift() const { return _keyframe_shift; }
+
 private:
     // target value, target frame
     using target_t = std::pair<uint16_t, uint32_t>;
@@ -198,15 +203,20 @@ private:
         auto val_ofs = val_gen(effect_rng);
         auto nf = frame + frame_gen(effect_rng);
 
-        if (val_ofs >= 0)
-            return target_t { sat_add(MBI::LED_MAX / 2, val_ofs), nf };
-        else
-            return target_t { std::max<uint16_t>(sat_ofs(MBI::LED_MAX / 2, val_ofs), MBI::LED_MAX / 10), nf };
+        return target_t { std::clamp<int32_t>(MBI::LED_MAX / 2 + val_ofs, MBI::LED_MAX / 10, MBI::LED_MAX), nf };
     }
 
     std::uniform_int_distribution<int16_t> val_gen;
     std::uniform_int_distribution<uint16_t> frame_gen;
     std::array<target_t, MBI::N_LEDS> targets;
+    uint8_t _keyframe_shift;
+};
+
+// Show frames that come from elsewhere (e.g. streamed over the UART) as they are. They're always 16-bit.
+template <class MBI> struct External : MBIEffect<MBI> {
+    void operator()(MBI& mbi, const uint32_t) { from16<MBI>(mbi.get_buffer(), frame); }
+
+    std::array<uint16_t, MBI::N_LEDS> frame {};
 };
 
 template <class MBI> struct FirstN : MBIEffect<MBI> {
@@ -0,0 +1,24 @@
+#pragma once
+#include "gcem.hpp"
+
+#include <array>
+#include <cstdint>
+
+#include "config.h"
+
+// Output stage expansion for 8-bit frame buffers: one flash table entry per pixel value, the 16-bit output value before
+// brightness scaling. Gamma correction is baked into the table at compile time, so correcting an LED is a table load
+// instead of the Chebyshev approximation's float maths. 512 bytes of flash.
+namespace expand {
+template <bool gamma_corrected> constexpr std::array<uint16_t, 256> table()
+{
+    std::array<uint16_t, 256> t {};
+    for (auto i = 1U; i < t.size(); i++) { // 0 stays 0, and doesn't go through log(0) in gcem::pow
+        if (gamma_corrected)
+            t[i] = gcem::pow(i / 255.0, static_cast<double>(GAMMA)) * UINT16_MAX + 0.5;
+        else
+            t[i] = i * 257; // 0xff -> 0xffff
+    }
+    return t;
+}
+}
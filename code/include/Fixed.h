@@ -0,0 +1,175 @@
+#pragma once
+#include "gcem.hpp"
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+
+// Fixed point arithmetic for effects. Anything curved in float (sin, exp, pow, even a divide) goes through soft-float
+// routines on the M0, hundreds of cycles each (see apply_correction). These are integer only: the curves come from
+// small tables generated at compile time with gcem, interpolated linearly.
+//
+// Angles are a uint16_t phase, 65536 to the turn, so they wrap for free like the phases in Spatial.h.
+namespace fixed {
+constexpr int16_t sat16(const int32_t v) { return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v; }
+
+constexpr int32_t sat32(const int64_t v) { return v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : v; }
+
+// Q1.15, -1 to just under 1. All operators saturate.
+struct q15 {
+    static constexpr int32_t ONE = 1 << 15;
+
+    int16_t raw;
+
+    static constexpr q15 from_raw(const int32_t r) { return { sat16(r) }; }
+    // For constants, at compile time
+    static constexpr q15 from(const double v) { return from_raw(v * ONE + (v < 0 ? -0.5 : 0.5)); }
+
+    friend constexpr q15 operator+(const q15 a, const q15 b) { return from_raw(a.raw + b.raw); }
+    friend constexpr q15 operator-(const q15 a, const q15 b) { return from_raw(a.raw - b.raw); }
+    constexpr q15 operator-() const { return from_raw(-raw); }
+    // Rounded, a 16x16 multiply
+    friend constexpr q15 operator*(const q15 a, const q15 b) { return from_raw((a.raw * b.raw + (1 << 14)) >> 15); }
+
+    friend constexpr bool operator==(const q15 a, const q15 b) { return a.raw == b.raw; }
+    friend constexpr bool operator<(const q15 a, const q15 b) { return a.raw < b.raw; }
+};
+
+// Q16.16, about -32768 to 32768. All operators saturate. Multiplying needs a 32x32->64 multiply, a library call on the
+// M0 (but far cheaper than float); dividing goes through reciprocal().
+struct q16 {
+    static constexpr int32_t ONE = 1 << 16;
+
+    int32_t raw;
+
+    static constexpr q16 from_raw(const int64_t r) { return { sat32(r) }; }
+    static constexpr q16 from(const double v) { return from_raw(v * ONE + (v < 0 ? -0.5 : 0.5)); }
+    static constexpr q16 from_int(const int16_t v) { return { v * ONE }; }
+    static constexpr q16 from(const q15 v) { return { v.raw * 2 }; }
+
+    // Rounded towards -infinity
+    constexpr int16_t to_int() const { return raw >> 16; }
+
+    friend constexpr q16 operator+(const q16 a, const q16 b) { return from_raw(static_cast<int64_t>(a.raw) + b.raw); }
+    friend constexpr q16 operator-(const q16 a, const q16 b) { return from_raw(static_cast<int64_t>(a.raw) - b.raw); }
+    constexpr q16 operator-() const { return from_raw(-static_cast<int64_t>(raw)); }
+    friend constexpr q16 operator*(const q16 a, const q16 b)
+    {
+        return from_raw((static_cast<int64_t>(a.raw) * b.raw + (1 << 15)) >> 16);
+    }
+    friend q16 operator/(const q16 a, const q16 b);
+
+    friend constexpr bool operator==(const q16 a, const q16 b) { return a.raw == b.raw; }
+    friend constexpr bool operator<(const q16 a, const q16 b) { return a.raw < b.raw; }
+};
+
+constexpr double PI = 3.14159265358979323846;
+
+// sin over the first quarter turn, in 64 steps (and the end point), Q1.15. 130 bytes.
+constexpr uint8_t SIN_STEPS = 64;
+constexpr std::array<int16_t, SIN_STEPS + 1> sin_table()
+{
+    std::array<int16_t, SIN_STEPS + 1> t {};
+    for (auto i = 0U; i < t.size(); i++)
+        t[i] = q15::from(gcem::sin(i * PI / 2 / SIN_STEPS)).raw;
+    return t;
+}
+constexpr auto SIN_TABLE = sin_table();
+
+// 2^(i/32) - 1 for i 0-31, Q0.16. 2^1 - 1 doesn't fit, but it's known. 64 bytes.
+constexpr uint8_t EXP2_STEPS = 32;
+constexpr std::array<uint16_t, EXP2_STEPS> exp2_table()
+{
+    std::array<uint16_t, EXP2_STEPS> t {};
+    for (auto i = 0U; i < t.size(); i++)
+        t[i] = (gcem::pow(2.0, static_cast<double>(i) / EXP2_STEPS) - 1) * 65536 + 0.5;
+    return t;
+}
+constexpr auto EXP2_TABLE = exp2_table();
+
+// 1/m for m in [0.5, 1) in 64 steps, taken at the middle of each step, less 1 to fit in Q0.16. 128 bytes.
+constexpr uint8_t RECIP_STEPS = 64;
+constexpr std::array<uint16_t, RECIP_STEPS> recip_table()
+{
+    std::array<uint16_t, RECIP_STEPS> t {};
+    for (auto i = 0U; i < t.size(); i++)
+        t[i] = (1 / (0.5 + (i + 0.5) / (2 * RECIP_STEPS)) - 1) * 65536 + 0.5;
+    return t;
+}
+constexpr auto RECIP_TABLE = recip_table();
+
+// Within ~1.2e-4 of the real thing (4 LSBs)
+inline q15 sin(const uint16_t angle)
+{
+    // Fold into the first quarter
+    uint16_t a = angle & 0x7fff;
+    if (a > 0x4000)
+        a = 0x8000 - a;
+    auto i = a >> 8;
+    int32_t v = SIN_TABLE[i];
+    if (auto frac = a & 0xff)
+        v += ((SIN_TABLE[i + 1] - v) * frac) >> 8;
+    return { static_cast<int16_t>(angle & 0x8000 ? -v : v) };
+}
+
+inline q15 cos(const uint16_t angle) { return sin(angle + 0x4000); }
+
+// 2^x, within ~6e-5 relative from 1 up, and a LSB or so below that. Saturates above 2^15, and goes to 0 below 2^-16.
+inline q16 exp2(const q16 x)
+{
+    int32_t n = x.to_int();
+    uint32_t f = x.raw & 0xffff;
+    auto i = f >> 11;
+    uint32_t lo = EXP2_TABLE[i];
+    uint32_t hi = i + 1 < EXP2_STEPS ? EXP2_TABLE[i + 1] : 65536;
+    uint32_t m = 65536 + lo + (((hi - lo) * (f & 0x7ff)) >> 11); // 2^f, Q16
+    if (n >= 15)
+        return { INT32_MAX };
+    if (n >= 0)
+        return { static_cast<int32_t>(m << n) };
+    return { n > -32 ? static_cast<int32_t>(m >> -n) : 0 };
+}
+
+// e^x = 2^(x log2(e))
+inline q16 exp(const q16 x) { return exp2(x * q16::from(1.4426950408889634)); }
+
+// 1/x for x > 0 (0 saturates), within ~6e-5 relative, or 1 LSB for large x. A table lookup for 6 bits, then a
+// refinement step, no division.
+inline q16 reciprocal(const q16 x)
+{
+    if (x.raw <= 0)
+        return { INT32_MAX };
+
+    // x = m * 2^(bits - 16), m in [0.5, 1). No CLZ on the M0, find the top bit by halves.
+    uint32_t v = x.raw;
+    int8_t bits = 0;
+    for (auto s : { 16, 8, 4, 2, 1 }) {
+        if (v >> s) {
+            v >>= s;
+            bits += s;
+        }
+    }
+    bits++;
+    // m as Q1.15, then 1/m ~ r as Q16
+    uint32_t m15 = x.raw;
+    m15 = bits > 15 ? m15 >> (bits - 15) : m15 << (15 - bits);
+    uint32_t r = 65536 + RECIP_TABLE[(m15 >> 8) & (RECIP_STEPS - 1)];
+    // With e = 1 - m r, 1/m = r / (1 - e) = r (1 + e + e^2 + ...). Newton-Raphson stops at e, which always comes out
+    // low by r e^2 (4 LSBs at 1/1); one more multiply takes in e^2 too. e is small, so r times it fits in 32 bits.
+    int32_t err = 65536 - static_cast<int32_t>((m15 * r) >> 15);
+    int32_t re = (static_cast<int32_t>(r) * err + (1 << 15)) >> 16;
+    r += re + ((re * err + (1 << 15)) >> 16);
+
+    // 1/x = 1/m * 2^(16 - bits)
+    int8_t shift = 16 - bits;
+    if (shift >= 0)
+        return { r >= (static_cast<uint32_t>(INT32_MAX) >> shift) ? INT32_MAX : static_cast<int32_t>(r << shift) };
+    return { static_cast<int32_t>(r >> -shift) };
+}
+
+inline q16 operator/(const q16 a, const q16 b)
+{
+    auto r = reciprocal(b.raw < 0 ? -b : b);
+    return b.raw < 0 ? -(a * r) : a * r;
+}
+}
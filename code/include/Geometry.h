@@ -0,0 +1,136 @@
+#pragma once
+#include "gcem.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "config.h"
+
+// Tables describing where the LEDs are, computed at compile time from their positions (LED_POS) so that spatial
+// effects only ever index a flash table per LED. Every table is indexed by LED and scaled to 0-255, so effects can
+// treat any of them as a phase offset.
+namespace geometry {
+template <size_t n> constexpr led_pos_t centre(const std::array<led_pos_t, n>& pos)
+{
+    int32_t x = 0, y = 0;
+    for (auto& p : pos) {
+        x += p.x;
+        y += p.y;
+    }
+    return { static_cast<int16_t>(x / static_cast<int32_t>(n)), static_cast<int16_t>(y / static_cast<int32_t>(n)) };
+}
+
+// Distance from the centre, the furthest LED is 255
+template <size_t n> constexpr std::array<uint8_t, n> distances(const std::array<led_pos_t, n>& pos)
+{
+    auto c = centre(pos);
+    std::array<double, n> d {};
+    double furthest = 0;
+    for (auto i = 0U; i < n; i++) {
+        double dx = pos[i].x - c.x, dy = pos[i].y - c.y;
+        d[i] = gcem::sqrt(dx * dx + dy * dy);
+        furthest = d[i] > furthest ? d[i] : furthest;
+    }
+    std::array<uint8_t, n> t {};
+    for (auto i = 0U; i < n; i++)
+        t[i] = d[i] * 255 / furthest + 0.5;
+    return t;
+}
+
+// Direction from the centre, clockwise from straight up, 256 to the turn
+template <size_t n> constexpr std::array<uint8_t, n> angles(const std::array<led_pos_t, n>& pos)
+{
+    auto c = centre(pos);
+    std::array<uint8_t, n> t {};
+    for (auto i = 0U; i < n; i++) {
+        double a = gcem::atan2(static_cast<double>(pos[i].x - c.x), static_cast<double>(c.y - pos[i].y));
+        t[i] = static_cast<int32_t>(a * 128 / 3.14159265358979323846 + 256.5) & 0xff;
+    }
+    return t;
+}
+
+// Position along one axis (member x or y), the lowest LED is 0 and the highest 255
+template <size_t n> constexpr std::array<uint8_t, n> along(const std::array<led_pos_t, n>& pos, int16_t led_pos_t::*axis)
+{
+    int16_t lo = INT16_MAX, hi = INT16_MIN;
+    for (auto& p : pos) {
+        lo = p.*axis < lo ? p.*axis : lo;
+        hi = p.*axis > hi ? p.*axis : hi;
+    }
+    std::array<uint8_t, n> t {};
+    for (auto i = 0U; i < n; i++)
+        t[i] = ((pos[i].*axis - lo) * 255 + (hi - lo) / 2) / (hi - lo);
+    return t;
+}
+
+// Which LEDs neighbour each other, as a bit mask per LED: each LED's k nearest, plus any LED that has it among its k
+// nearest, so that light can spread both ways between them
+template <size_t k, size_t n> constexpr std::array<uint16_t, n> adjacency(const std::array<led_pos_t, n>& pos)
+{
+    static_assert(k < n && n <= 16, "Not enough LEDs, or too many for a mask");
+    std::array<uint16_t, n> adj {};
+    for (auto i = 0U; i < n; i++) {
+        // Selection of the k nearest, n is small
+        uint16_t taken = 1 << i;
+        for (auto j = 0U; j < k; j++) {
+            int32_t best = INT32_MAX;
+            uint8_t nearest = i;
+            for (auto m = 0U; m < n; m++) {
+                int32_t dx = pos[m].x - pos[i].x, dy = pos[m].y - pos[i].y;
+                if (!(taken & 1 << m) && dx * dx + dy * dy < best) {
+                    best = dx * dx + dy * dy;
+                    nearest = m;
+                }
+            }
+            taken |= 1 << nearest;
+            adj[i] |= 1 << nearest;
+            adj[nearest] |= 1 << i;
+        }
+    }
+    return adj;
+}
+
+// The most neighbours any LED has
+template <size_t k, size_t n> constexpr size_t degree(const std::array<led_pos_t, n>& pos)
+{
+    size_t most = 0;
+    for (auto m : adjacency<k>(pos)) {
+        size_t d = 0;
+        for (; m; m &= m - 1)
+            d++;
+        most = d > most ? d : most;
+    }
+    return most;
+}
+
+// Each LED's neighbours as a list, padded out to d entries with the LED itself. Effects that take the brightest (or
+// dimmest) neighbour can include themselves harmlessly, and skip checking for the end of the list.
+template <size_t d, size_t k, size_t n>
+constexpr std::array<std::array<uint8_t, d>, n> neighbours(const std::array<led_pos_t, n>& pos)
+{
+    auto adj = adjacency<k>(pos);
+    std::array<std::array<uint8_t, d>, n> t {};
+    for (auto i = 0U; i < n; i++) {
+        auto j = 0U;
+        for (auto m = 0U; m < n; m++)
+            if (adj[i] & 1 << m)
+                t[i][j++] = m;
+        for (; j < d; j++)
+            t[i][j] = i;
+    }
+    return t;
+}
+
+// The board's tables
+
+// Neighbours are the 3 nearest LEDs each way, which gives up to 7 per LED on this board (the three in the middle of the
+// bottom are close together and everything's nearest). With 2 the bottom isn't connected to the waist.
+constexpr uint8_t K_NEAREST = 3;
+
+constexpr auto DIST = distances(LED_POS);
+constexpr auto ANGLE = angles(LED_POS);
+constexpr auto X = along(LED_POS, &led_pos_t::x);
+constexpr auto Y = along(LED_POS, &led_pos_t::y);
+constexpr auto NEIGHBOURS = neighbours<degree<K_NEAREST>(LED_POS), K_NEAREST>(LED_POS);
+}
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <array>
-#include <cmath>
 #include <cstdint>
 #include <functional>
 
@@ -9,12 +8,15 @@
 #include <libopencm3/stm32/rcc.h>
 #include <libopencm3/stm32/timer.h>
 
-#include "ChebyshevFit.h"
+#include "OutputStage.h"
 #include "util.h"
 
 using std::array;
 
-template <uint8_t n_leds, uint32_t gclk_timer, rcc_periph_clken gclk_timer_rcc> class MBI5043 {
+// The frame buffer and everything done to it on the way out is in OutputStage, this is the driver itself. See there for
+// the pixel type px_t.
+template <uint8_t n_leds, uint32_t gclk_timer, rcc_periph_clken gclk_timer_rcc, class px_t = uint16_t>
+class MBI5043 : public OutputStage<n_leds, px_t> {
 public:
     // Configuration bit positions
     static constexpr uint16_t GCLK_SHIFT_B1 = 15;
@@ -35,50 +37,56 @@ public:
     // Startup configuration register state.
     static constexpr uint16_t STARTUP_CONFIG = 0b0000001010110000;
 
-    static constexpr uint16_t LED_MAX = 0xffff;
-    static constexpr uint16_t LED_MIN = 0x0000;
-
-    static constexpr auto N_LEDS = n_leds;
+    uint16_t config;
 
-    using fb_t = array<uint16_t, n_leds>;
+    // After this many consecutive all-dark frames stop GCLK, and if dark_power_off also cut the driver's power, until
+    // the next frame with anything lit. 0 to never gate.
+    uint16_t dark_gate_frames = 0;
+    bool dark_power_off = false;
+    // Time for the driver to come out of reset after power is restored, in core clock cycles
+    uint32_t power_up_cycles = 0;
 
-    uint16_t bright;
-    uint16_t config;
+    // Worst case time taken to wake the driver and show a frame after a dark period, in core clock cycles. Only
+    // measured in DEBUG builds.
+    uint32_t max_wake_cycles = 0;
 
-    MBI5043(uint32_t port, uint32_t le_pin, uint32_t clk_pin, uint32_t data_pin, uint16_t brightness)
-        : bright(brightness)
+    MBI5043(uint32_t port, uint32_t le_pin, uint32_t clk_pin, uint32_t data_pin, uint32_t pwr_pin, uint16_t brightness)
+        : OutputStage<n_leds, px_t>(brightness)
         , _port(port)
         , _le_pin(le_pin)
         , _clk_pin(clk_pin)
         , _data_pin(data_pin)
+        , _pwr_pin(pwr_pin)
     {
         config = STARTUP_CONFIG;
         timer_setup();
     }
 
-    // Get a buffer to draw (the next frame) to
-    fb_t& get_buffer() { return buffers[0]; }
-    // Get the buffer containing the next frame (which will be the frame previous to what is about to be drawn into
-    // get_buffer)
-    const fb_t& cur_frame() const { return buffers[0]; }
+    // Whether the driver is powered (and drawing its quiescent current)
+    bool powered() const { return _powered; }
+    bool gated() const { return _gated; }
 
-    // Clear all buffers (new effect)
-    void clear_buffers()
+    // Write the next step towards the last keyframe to the LEDs (see OutputStage::correct_frame)
+    template <bool gamma_corrected = true, bool dithered = false, bool calibrated = ENABLE_CALIBRATION> void put_frame()
     {
-        for (auto& b : buffers) {
-            std::fill(b.begin(), b.end(), 0);
+        auto sum = this->template correct_frame<gamma_corrected, dithered, calibrated>();
+        auto& fb = this->output();
+
+        bool woke = false;
+        [[maybe_unused]] uint32_t wake_start;
+        if (sum == 0) {
+            // Nothing to show, and the driver is already idle showing nothing
+            if (_gated)
+                return;
+        } else {
+            _dark_frames = 0;
+            if (_gated) {
+                if (DEBUG)
+                    wake_start = cycle_stamp();
+                ungate();
+                woke = true;
+            }
         }
-    }
-
-    // Write the buffer to the LEDs.
-    // Current implementation of gamma correction takes about 1.5ms/frame @ 8MHz
-    template <bool gamma_corrected = true> void put_frame()
-    {
-        // Draw from this buffer, 'corrections' will write to it
-        auto& fb = buffers[1];
-
-        std::transform(buffers[0].begin(), buffers[0].end(), fb.begin(),
-            [this](uint16_t val) { return apply_correction<gamma_corrected>(val); });
 
         // Start with all lines low
         gpio_clear(_port, _le_pin | _clk_pin | _data_pin);
@@ -93,6 +101,24 @@ public:
         // Then we write an empty word with LE asserted for the last 3 clocks to call for latch into the output
         // comparators
         put_word(0, 3);
+
+        if (DEBUG && woke)
+            max_wake_cycles = std::max(max_wake_cycles, cycles_since(wake_start));
+
+        // Only gate once the dark frame has been latched, so the outputs are off when GCLK stops
+        if (sum == 0 && dark_gate_frames && ++_dark_frames >= dark_gate_frames)
+            gate();
+    }
+
+    // Switch the driver's supply. It has a documented quiescent current of multiple mA, which is way too high when we
+    // need a standby current of µA when off. The switch is a PFET, so active low.
+    void power(bool on)
+    {
+        if (on)
+            gpio_clear(_port, _pwr_pin);
+        else
+            gpio_set(_port, _pwr_pin);
+        _powered = on;
     }
 
     void put_config() const
@@ -113,17 +139,57 @@ public:
     void stop()
     {
         config &= ~(1 << ENABLE);
-        put_config();
+        if (_powered)
+            put_config();
         timer_disable_counter(gclk_timer);
         rcc_periph_clock_disable(gclk_timer_rcc);
+        _gated = false;
     }
 
-private:
-    // one buffer for the frame as generated, one for the gamma-corrected and scaled output
-    array<fb_t, 2> buffers;
+    // Change the GCLK timer prescaler, e.g. to keep GCLK constant when the system clock is divided down. GCLK is the
+    // timer clock / (prescaler + 1) / 2.
+    void set_gclk_prescaler(const uint16_t psc)
+    {
+        rcc_periph_clock_enable(gclk_timer_rcc);
+        timer_set_prescaler(gclk_timer, psc);
+        if (!(config & (1 << ENABLE)))
+            rcc_periph_clock_disable(gclk_timer_rcc);
+    }
 
+private:
     uint32_t _port, _le_pin, _clk_pin, _data_pin;
 
+    uint32_t _pwr_pin;
+    bool _powered = false;
+    bool _gated = false;
+    uint16_t _dark_frames = 0;
+
+    // Stop GCLK (and maybe power) while everything is dark
+    void gate()
+    {
+        timer_disable_counter(gclk_timer);
+        rcc_periph_clock_disable(gclk_timer_rcc);
+        if (dark_power_off)
+            power(false);
+        _gated = true;
+    }
+
+    // Bring the driver back to where start() left it
+    void ungate()
+    {
+        if (!_powered) {
+            power(true);
+            // Wait out the driver's power on reset, then restore the configuration it lost
+            auto t = cycle_stamp();
+            while (cycles_since(t) < power_up_cycles)
+                ;
+            put_config();
+        }
+        rcc_periph_clock_enable(gclk_timer_rcc);
+        timer_enable_counter(gclk_timer);
+        _gated = false;
+    }
+
     void put_word(const uint16_t w, const uint8_t latch_clocks = 1) const
     {
         // mask each bit, starting with MSB
@@ -158,38 +224,4 @@ private:
 
         rcc_periph_clock_disable(gclk_timer_rcc);
     }
-
-    // Runtime ~1.4ms / frame or about 8% of frame time. Pretty expensive in space.
-    template <bool gamma_corrected = true> uint16_t apply_correction(const uint16_t val)
-    {
-        if (val == 0)
-            return 0; // Off is off
-
-        if (gamma_corrected) {
-            // The following is equivalent to:>
-            // float y = std::pow(float(val) * (1.0F / LED_MAX), GAMMA);
-
-            // Transform from uint16 range to [-1,1]
-            float u = ChebyshevFit::x_to_u(float(val) * (1.0F / LED_MAX), 0.0f,
-                1.0f); // Using * here instead of / saves 500b of flash since we
-                       // avoid pulling in fdiv that can't be optimized out
-            float y = (gamma_coeffs[0] + gamma_coeffs[1] * u + gamma_coeffs[2] * (2 * u * u - 1)
-                + gamma_coeffs[3] * (4 * u * u * u - 3 * u));
-
-            // The approximation can (and does) return values < 0 and > 1, so
-            // truncate cleanly
-            if (y > 1.0)
-                return bright;
-            else if (y < 0.0)
-                return 0;
-            else
-                return y * bright;
-        } else {
-            return val * bright;
-        }
-    }
-
-public:
-    static constexpr auto gamma_coeffs = ChebyshevFit::fit<float>(
-        [](float x) constexpr->float { return gcem::pow(x, GAMMA); }, 0, 1);
 };
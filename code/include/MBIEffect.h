@@ -1,19 +1,30 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <functional>
 #include <random>
 #include <vector>
 
-#include "MBI5043.h"
 #include "config.h"
 #include "rng.h"
+#include "util.h"
 
 // DEFINITIONS
 
 // Why not use dynamic dispatch for something like this...
 template <class MBI> struct MBIEffect {
     virtual void operator()(MBI& mbi, const uint32_t frames) = 0;
+
+    // Render a keyframe every 2^keyframe_shift frames, the output stage interpolates in between. Effects that
+    // move slowly relative to the frame rate can save most of their render cost this way.
+    virtual uint8_t keyframe_shift() const { return 0; }
+
+    // The shift it's actually being called at, set by whoever draws it: its own keyframe_shift(), plus any the main
+    // loop adds (low supply, running late). Effects that count calls rather than reading `frames` must advance by
+    // frames_per_call() each time, or they'd slow down rather than just render less often.
+    uint8_t frame_shift = 0;
+    uint16_t frames_per_call() const { return 1U << frame_shift; }
 };
 
 // HELPERS / GLOBALS
@@ -21,6 +32,19 @@ template <class MBI> struct MBIEffect {
 // Let's have ourselves a global RNG for all effects to use
 auto effect_rng = pcg();
 
+// One 16-bit value at the driver's pixel depth
+template <class MBI> constexpr typename MBI::pixel_t from16(const uint16_t v)
+{
+    return v >> (16 - 8 * sizeof(typename MBI::pixel_t));
+}
+
+// Copy a frame from a 16-bit source (baked tables, scripts, the stream) into a frame of the driver's pixel depth
+template <class MBI> void from16(typename MBI::fb_t& fb, const std::array<uint16_t, MBI::N_LEDS>& src)
+{
+    for (auto i = 0U; i < MBI::N_LEDS; i++)
+        fb[i] = from16<MBI>(src[i]);
+}
+
 // Fade to a target buffer state over a given number of frames (linearly interpolate). Will interpolate the next frame
 // and store it into `out`. It is intended for the calling effect to set up the buffer in its own static storage, with
 // the target frame number, and delegate to this function until the target frame is reached, then generate the next
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Button.h"
+#include "DeadlineGovernor.h"
+#include "EffectSetup.h"
+#include "config.h"
+#include "util.h"
+
+// The main loop's decisions, without the hardware: which effect is drawn, the button menus, stepping through effects by
+// themselves and when to power off. main.cpp runs it on the frames counted by SysTick, with the button fed from its
+// interrupts, and adds the hardware around it (clock scaling, supply sampling, the UART). On the PC it runs on virtual
+// frames as fast as they can be drawn, so hours of button and auto power off behaviour can be checked in a fraction of
+// a second (see test/test_MAINLOOP, tools/timewarp.cpp).
+class MainLoop {
+public:
+    enum menu_state_t : uint8_t { MAIN, BRIGHT };
+
+    MainLoop(mbi_t& mbi, Button& button)
+        : mbi(mbi)
+        , button(button)
+    {
+    }
+
+    uint8_t cur_effect = 0;
+    uint8_t cur_bright = 6;
+    // Highest cur_bright the supply can sustain (see SupplyGovernor)
+    uint8_t max_bright = 6;
+    menu_state_t menu_state = MAIN;
+
+    // Auto power off when we get to this frame
+    uint32_t apo_frame = APO_FRAMES;
+
+    // The last button event acted on, for debug output
+    Button::event_t event = Button::NONE;
+
+    // Quality steps for effects that can't keep up, SysTick reports late frames to it
+    DeadlineGovernor deadline;
+
+    // This is a reference to the MBIEffect instance that will be drawn, it may differ from cur_effect for menus etc.
+    effect_ref draw_frame = effects[0];
+
+    void set_effect(const uint8_t i)
+    {
+        cur_effect = i % effects.size();
+        draw_frame = effects[cur_effect];
+        mbi.clear_buffers();
+        deadline.reset();
+    }
+
+    // Draw `top` over whatever is showing, until the next set_effect()
+    void show_overlay(MBIEffect<mbi_t>& top, const overlay_t::blend_t mode, const uint16_t alpha = 256)
+    {
+        if (&draw_frame.get() != &overlay) {
+            overlay.set(0, &draw_frame.get());
+            overlay.seed(0, mbi.get_buffer());
+            draw_frame = overlay;
+        }
+        overlay.set(1, &top, mode, alpha);
+    }
+
+    // Set the output scaling for cur_bright, limited by what the supply can sustain
+    void apply_brightness()
+    {
+        auto b = std::min(cur_bright, max_bright);
+        mbi.bright = (static_cast<uint32_t>(1) << (b + 9)) - 1;
+    }
+
+    // Draw the next frame, returns the keyframe shift it was drawn at: the effect's own, slowed down further if it's been
+    // running late, and by `extra` (the supply level's). The effect is told, so it keeps its speed.
+    uint8_t draw(const uint32_t frame, const uint8_t extra = 0)
+    {
+        auto& e = draw_frame.get();
+        e.frame_shift = e.keyframe_shift() + deadline.shift + extra;
+        e(mbi, frame);
+        return e.frame_shift;
+    }
+
+    // Clock governor slot of what's being drawn. Menus aren't an effect, they get their own slot.
+    uint8_t slot() const { return &draw_frame.get() == &effects[cur_effect].get() ? cur_effect : effects.size(); }
+
+    // Streamed frames take over from the effect, but not from the menus
+    void show_stream()
+    {
+        if (menu_state == MAIN)
+            draw_frame = streamed;
+    }
+    void end_stream()
+    {
+        if (&draw_frame.get() == &streamed)
+            set_effect(cur_effect);
+    }
+
+    // One pass of the main loop at `frame`, after any drawing: act on button presses, drop effects that miss their
+    // deadline and count down to auto power off. `streaming` is whether a host is streaming frames, which keeps us
+    // awake too. Returns false when it's time to power off.
+    bool step(const uint32_t frame, const bool streaming)
+    {
+        apo_frame = (streaming ? frame : button.last_activity) + APO_FRAMES;
+
+        // An effect that's still late at the lowest rate is dropped, but not from under a menu
+        if (deadline.update(frame, menu_state == MAIN))
+            set_effect(cur_effect + 1);
+
+        // Frames go by without a pass of the main loop when it runs late, so the exact frame may never be seen
+        if (frame_reached(frame, apo_frame))
+            return false;
+
+        // If the button is still held, don't act yet, but update the display to show we received the input
+        auto held = button.held(frame);
+        if (held >= PWR_PRESS) {
+            // Fade the LEDs nearly out to indicate we are about to turn off
+            show_overlay(AllOff, overlay_t::ALPHA, 224);
+        } else if (held > LONG_PRESS) {
+            // Turn on one LED to indicate we received the long-press
+            indicator.n = 1;
+            show_overlay(indicator, overlay_t::MAX);
+        }
+
+        // Presses are timed by the button interrupts, we just act on them
+        event = button.pop();
+        switch (event) {
+        case Button::SHORT:
+            menu_state = menu_state == MAIN ? press_main() : press_bright();
+            break;
+        case Button::LONG:
+            menu_state = menu_state == MAIN ? long_press_main() : long_press_bright();
+            break;
+        case Button::POWER:
+            // I would rather this happened immediately when the button has been held for a few seconds, but this
+            // causes the processor to be unable to wake up. Wait DEBOUNCE_DELAY frames after PWR_SW released to make
+            // sure it has settled before powering off
+            power_off_frame = frame + DEBOUNCE_DELAY;
+            break;
+        case Button::NONE:
+            break;
+        }
+
+        return !(power_off_frame && frame_reached(frame, power_off_frame));
+    }
+
+private:
+    mbi_t& mbi;
+    Button& button;
+
+    uint32_t power_off_frame = 0;
+
+    menu_state_t press_main()
+    {
+        set_effect(cur_effect + 1);
+        return MAIN;
+    }
+
+    menu_state_t press_bright()
+    {
+        cur_bright = cur_bright == 0 ? 6 : cur_bright - 1;
+        apply_brightness();
+
+        indicator.n = cur_bright + 1;
+        show_overlay(indicator, overlay_t::MAX);
+        return BRIGHT;
+    }
+
+    menu_state_t long_press_main()
+    {
+        indicator.n = cur_bright + 1;
+        show_overlay(indicator, overlay_t::MAX);
+        return BRIGHT;
+    }
+
+    menu_state_t long_press_bright()
+    {
+        set_effect(cur_effect);
+        return MAIN;
+    }
+};
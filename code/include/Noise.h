@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include "MBIEffect.h"
+
+// Value noise: random values on a grid, smoothly interpolated in between. The randomness is a fixed permutation of
+// 0-255 made at compile time, so sampling it anywhere costs a couple of table lookups and multiplies, and the same
+// point always gives the same value. Effects can index it by LED and frame instead of keeping per-LED state and
+// drawing from effect_rng.
+//
+// Coordinates are 8.8 fixed point: the top bits pick the grid cell, the low 8 how far across it. The grid repeats
+// every 256 cells.
+namespace noise {
+// Fisher-Yates with a xorshift, at compile time. 256 bytes of flash.
+constexpr std::array<uint8_t, 256> permutation(uint32_t seed)
+{
+    std::array<uint8_t, 256> p {};
+    for (auto i = 0U; i < p.size(); i++)
+        p[i] = i;
+    for (auto i = p.size() - 1; i > 0; i--) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        auto j = seed % (i + 1);
+        auto t = p[i];
+        p[i] = p[j];
+        p[j] = t;
+    }
+    return p;
+}
+constexpr auto PERM = permutation(0x2020c0de);
+
+// 3f^2 - 2f^3 over 0-255, so the slope is 0 at the grid points and the cells join without creases
+constexpr uint8_t smooth(const uint8_t f) { return (f * f * (3 * 256 - 2 * f)) >> 16; }
+
+// Interpolate between two lattice values, giving 16 bits (up to 255 << 8)
+constexpr uint16_t lerp(const uint8_t a, const uint8_t b, const uint8_t s) { return (a << 8) + (b - a) * s; }
+
+// The value at a grid point
+constexpr uint8_t lattice(const uint8_t x, const uint8_t y) { return PERM[(PERM[x] + y) & 0xff]; }
+
+// One dimensional noise, 0 to 255 << 8. Different `row`s are unrelated.
+constexpr uint16_t value(const uint16_t x, const uint8_t row = 0)
+{
+    uint8_t i = x >> 8;
+    return lerp(lattice(i, row), lattice(i + 1, row), smooth(x & 0xff));
+}
+
+// Two dimensional noise, 0 to 255 << 8
+constexpr uint16_t value2(const uint16_t x, const uint16_t y)
+{
+    uint8_t i = x >> 8, j = y >> 8, sx = smooth(x & 0xff);
+    uint16_t top = lerp(lattice(i, j), lattice(i + 1, j), sx);
+    uint16_t bottom = lerp(lattice(i, j + 1), lattice(i + 1, j + 1), sx);
+    return top + ((static_cast<int32_t>(bottom - top) * smooth(y & 0xff)) >> 8);
+}
+}
+
+// Like Twinkle, each LED wanders about half brightness by up to `magnitude`, but following its own row of noise
+// rather than random targets. There's no state per LED and no RNG draws, a noise lookup and a multiply each. `speed`
+// is how many frames it takes to cross a grid cell, about how long Twinkle takes to reach a target.
+template <class MBI> struct NoiseTwinkle : MBIEffect<MBI> {
+    NoiseTwinkle(const int16_t magnitude, const uint16_t speed, const uint8_t keyframe_shift = 0)
+        : _magnitude(magnitude)
+        , _step(0x10000 / speed)
+        , _keyframe_shift(keyframe_shift)
+    {
+    }
+
+    void operator()(MBI& mbi, const uint32_t frame)
+    {
+        auto& fb = mbi.get_buffer();
+        // 8.8 time, wrapping after 256 cells
+        uint16_t t = (frame * _step) >> 8;
+        for (auto i = 0U; i < MBI::N_LEDS; i++) {
+            int32_t ofs = ((noise::value(t, i) - 0x8000) * _magnitude) >> 15;
+            fb[i] = std::clamp<int32_t>(MBI::LED_MAX / 2 + ofs, MBI::LED_MAX / 10, MBI::LED_MAX);
+        }
+    }
+
+    uint8_t keyframe_shift() const { return _keyframe_shift; }
+
+private:
+    int16_t _magnitude;
+    uint32_t _step;
+    uint8_t _keyframe_shift;
+};
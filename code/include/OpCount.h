@@ -0,0 +1,183 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+// Counting stand-ins for the numeric types, to estimate what code costs on the M0 from a host build. Time on a PC says
+// little about the M0, where the expensive things are calls into libgcc: every float operation (there's no FPU), every
+// division (no divider) and 64-bit multiplies. Code templated on its arithmetic types (e.g. the output stage's
+// correction, or the word_t of the effects that divide) can be instantiated with counted<T> in a test, and the counts
+// weighted by M0_CYCLES into an estimate. RNG draws can't be counted that way, tests count them from the generator.
+//
+// Only arithmetic is counted, not loads, stores or branches, and the compiler may fold operations on constants that
+// get counted here. Treat the estimates as a budget check, the DEBUG cycle reports are the real numbers.
+namespace opcount {
+enum op_t : uint8_t {
+    ALU, // 32-bit add, subtract, logic, shift, compare
+    MUL, // 32-bit multiply
+    DIV, // 32-bit divide or remainder, __aeabi_uidiv & co
+    FADD, // float add, subtract, compare, __aeabi_fadd & co
+    FMUL, // __aeabi_fmul
+    FDIV, // __aeabi_fdiv
+    FCONV, // float to/from integer, __aeabi_i2f & co
+    WIDE_ALU, // 64-bit add, subtract, logic, shift, compare (a few instructions inline)
+    WIDE_MUL, // __aeabi_lmul
+    WIDE_DIV, // __aeabi_uldivmod
+    RNG, // a draw from effect_rng: pcg32's 64-bit multiply-add and output permutation
+    N_OPS,
+};
+
+using counts_t = std::array<uint32_t, N_OPS>;
+
+// Rough M0 cycles per operation. The multiplier on the F030 is the single cycle one; the rest are libgcc's ARMv6-M
+// routines, which vary with their operands. An RNG draw is an __aeabi_lmul and a dozen 64-bit shifts and adds, not
+// counting what a distribution does with it.
+constexpr counts_t M0_CYCLES = { 1, 1, 45, 60, 50, 110, 30, 3, 25, 400, 60 };
+
+// Operations counted so far
+inline counts_t tally {};
+
+inline void reset() { tally.fill(0); }
+
+inline uint32_t cycles(const counts_t& counts)
+{
+    uint32_t total = 0;
+    for (auto i = 0U; i < N_OPS; i++)
+        total += counts[i] * M0_CYCLES[i];
+    return total;
+}
+
+template <class T> constexpr op_t kind(const op_t integer)
+{
+    if constexpr (std::is_floating_point_v<T>)
+        return integer == DIV ? FDIV : integer == MUL ? FMUL : FADD;
+    else if constexpr (sizeof(T) > 4)
+        return static_cast<op_t>(integer - ALU + WIDE_ALU);
+    else
+        return integer;
+}
+
+template <class T> struct counted;
+
+template <class T> struct is_counted : std::false_type { };
+template <class T> struct is_counted<counted<T>> : std::true_type { };
+
+// The plain type underneath a counted or plain arithmetic type
+template <class T> struct plain {
+    using type = T;
+};
+template <class T> struct plain<counted<T>> {
+    using type = T;
+};
+template <class T> using plain_t = typename plain<T>::type;
+
+template <class T> constexpr plain_t<T> value(const T v)
+{
+    if constexpr (is_counted<T>::value)
+        return v.v;
+    else
+        return v;
+}
+
+// Whether an operand of type A in a float operation needs converting at run time. Plain operands are usually
+// constants, which the compiler converts.
+template <class A> constexpr bool converted = is_counted<A>::value && !std::is_floating_point_v<plain_t<A>>;
+
+// Count an operation of kind `op` between operand types A and B done in type R, plus any conversion to float it needs
+template <class R, class A, class B> void count(const op_t op)
+{
+    if constexpr (std::is_floating_point_v<R>)
+        tally[FCONV] += converted<A> + converted<B>;
+    tally[kind<R>(op)]++;
+}
+
+template <class T> struct counted {
+    static_assert(std::is_arithmetic_v<T>, "Counts arithmetic types");
+    T v;
+
+    constexpr counted(const T value = 0)
+        : v(value)
+    {
+    }
+    template <class U, class = std::enable_if_t<std::is_arithmetic_v<U> && !std::is_same_v<U, T>>>
+    counted(const U value)
+        : v(static_cast<T>(value))
+    {
+        if constexpr (std::is_floating_point_v<T> != std::is_floating_point_v<U>)
+            tally[FCONV]++;
+    }
+    template <class U> counted(const counted<U> value)
+        : counted(value.v)
+    {
+    }
+
+    template <class U, class = std::enable_if_t<std::is_arithmetic_v<U>>> explicit operator U() const
+    {
+        if constexpr (std::is_floating_point_v<T> != std::is_floating_point_v<U>)
+            tally[FCONV]++;
+        return static_cast<U>(v);
+    }
+
+    counted operator-() const
+    {
+        tally[kind<T>(ALU)]++;
+        return -v;
+    }
+
+    template <class U> counted& operator+=(const U o) { return *this = *this + o; }
+    template <class U> counted& operator-=(const U o) { return *this = *this - o; }
+    template <class U> counted& operator*=(const U o) { return *this = *this * o; }
+    template <class U> counted& operator/=(const U o) { return *this = *this / o; }
+    template <class U> counted& operator>>=(const U o) { return *this = *this >> o; }
+    template <class U> counted& operator<<=(const U o) { return *this = *this << o; }
+};
+
+// Binary operators on a counted type and another counted or plain one, done in their common type
+#define OPCOUNT_BINARY(sym, op)                                                                                         \
+    template <class A, class B, class = std::enable_if_t<is_counted<A>::value || is_counted<B>::value>>                 \
+    auto operator sym(const A a, const B b)                                                                             \
+    {                                                                                                                   \
+        using R = decltype(value(a) sym value(b));                                                                      \
+        count<R, A, B>(op);                                                                                             \
+        return counted<R>(value(a) sym value(b));                                                                       \
+    }
+OPCOUNT_BINARY(+, ALU)
+OPCOUNT_BINARY(-, ALU)
+OPCOUNT_BINARY(*, MUL)
+OPCOUNT_BINARY(/, DIV)
+OPCOUNT_BINARY(%, DIV)
+OPCOUNT_BINARY(&, ALU)
+OPCOUNT_BINARY(|, ALU)
+OPCOUNT_BINARY(^, ALU)
+#undef OPCOUNT_BINARY
+
+// Shifts are done in the left operand's type
+#define OPCOUNT_SHIFT(sym)                                                                                              \
+    template <class A, class B, class = std::enable_if_t<is_counted<A>::value || is_counted<B>::value>>                 \
+    auto operator sym(const A a, const B b)                                                                             \
+    {                                                                                                                   \
+        using R = decltype(value(a) sym value(b));                                                                      \
+        tally[kind<R>(ALU)]++;                                                                                          \
+        return counted<R>(value(a) sym value(b));                                                                       \
+    }
+OPCOUNT_SHIFT(<<)
+OPCOUNT_SHIFT(>>)
+#undef OPCOUNT_SHIFT
+
+#define OPCOUNT_COMPARE(sym)                                                                                            \
+    template <class A, class B, class = std::enable_if_t<is_counted<A>::value || is_counted<B>::value>>                 \
+    bool operator sym(const A a, const B b)                                                                             \
+    {                                                                                                                   \
+        using R = decltype(value(a) + value(b));                                                                        \
+        count<R, A, B>(ALU);                                                                                            \
+        return value(a) sym value(b);                                                                                   \
+    }
+OPCOUNT_COMPARE(==)
+OPCOUNT_COMPARE(!=)
+OPCOUNT_COMPARE(<)
+OPCOUNT_COMPARE(>)
+OPCOUNT_COMPARE(<=)
+OPCOUNT_COMPARE(>=)
+#undef OPCOUNT_COMPARE
+}
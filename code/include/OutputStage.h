@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "ChebyshevFit.h"
+#include "Dither.h"
+#include "Expand.h"
+#include "config.h"
+
+// Everything between the frame effects draw and the values sent to the driver: the frame buffer, keyframe
+// interpolation, gamma correction, brightness and per-LED calibration, dithering and the output limit. No hardware, so
+// it runs as is on a PC (the golden frame tests drive effects through it); MBI5043 adds the wire protocol and power
+// management on top.
+//
+// Frames are drawn with pixels of type px_t. uint16_t is the driver's own depth. uint8_t halves the RAM of every frame
+// buffer effects draw into (this one and e.g. compositor layers'), and the output stage expands it to 16 bits with a
+// table (see Expand.h).
+template <uint8_t n_leds, class px_t = uint16_t> class OutputStage {
+    static_assert(std::is_same_v<px_t, uint8_t> || std::is_same_v<px_t, uint16_t>, "Pixels are 8 or 16 bits");
+
+public:
+    static constexpr uint16_t LED_MAX = std::numeric_limits<px_t>::max();
+    static constexpr uint16_t LED_MIN = 0x0000;
+
+    static constexpr auto N_LEDS = n_leds;
+
+    using pixel_t = px_t;
+    using fb_t = std::array<pixel_t, n_leds>;
+    // What's sent to the driver is always 16 bits
+    using out_t = std::array<uint16_t, n_leds>;
+
+    uint16_t bright;
+
+    // Upper bound on the sum of the corrected output values of a frame, frames over it are scaled down to fit. Used to
+    // cap the supply current (see PowerModel::max_out_sum).
+    uint32_t output_limit = UINT32_MAX;
+
+    OutputStage(const uint16_t brightness)
+        : bright(brightness)
+    {
+        rescale();
+    }
+
+    // Calibrate the LEDs with `cal` (n_leds entries, copied) instead of LED_CAL. correct_frame() reads the table, so on
+    // the card this mustn't run while SysTick could be outputting a frame.
+    void set_calibration(const led_cal_t* cal)
+    {
+        std::copy(cal, cal + n_leds, _cal.begin());
+        rescale();
+    }
+
+    // Get a buffer to draw (the next frame) to
+    fb_t& get_buffer() { return _draw ? *_draw : buffer; }
+    // Have get_buffer() hand out `fb` instead (e.g. a compositor layer), nullptr for the frame buffer. Returns the
+    // previous setting, to put back afterwards.
+    fb_t* draw_to(fb_t* fb)
+    {
+        auto prev = _draw;
+        _draw = fb;
+        return prev;
+    }
+    // Get the buffer containing the next frame (which will be the frame previous to what is about to be drawn into
+    // get_buffer)
+    const fb_t& cur_frame() const { return buffer; }
+    // The last corrected output frame, and the sum of its values
+    const out_t& output() const { return out; }
+    uint32_t output_sum() const { return _output_sum; }
+
+    // Clear all buffers (new effect)
+    void clear_buffers()
+    {
+        buffer.fill(0);
+        out.fill(0);
+        for (auto& b : keyframes) {
+            std::fill(b.begin(), b.end(), 0);
+        }
+        dither.reset();
+    }
+
+    // Take the frame drawn into get_buffer() as the next keyframe. The output interpolates linearly from whatever it is
+    // showing now to the new keyframe over the next 2^shift calls to put_frame, so effects can render at a fraction of
+    // the frame rate without visibly stepping.
+    void push_keyframe(const uint8_t shift)
+    {
+        for (auto i = 0U; i < n_leds; i++)
+            keyframes[0][i] = interpolated(i);
+        keyframes[1] = buffer;
+        _key_shift = shift;
+        _key_phase = 0;
+    }
+
+    // Whether the output has caught up with the last keyframe, so it's time for the next one
+    bool keyframe_due() const { return _key_phase >= (1U << _key_shift); }
+
+    // Work out the next step towards the last keyframe into output(), returning its sum.
+    // Current implementation of gamma correction takes about 1.5ms/frame @ 8MHz, with 8-bit pixels it's a table load
+    // and a multiply per LED. Dithering adds a handful of integer ops per LED on top of that, as does interpolating
+    // between keyframes. Calibration adds an add per LED, its scaling is folded into bright's.
+    template <bool gamma_corrected = true, bool dithered = false, bool calibrated = ENABLE_CALIBRATION>
+    uint32_t correct_frame()
+    {
+        // Draw from this buffer, 'corrections' will write to it
+        auto& fb = out;
+
+        if (!keyframe_due())
+            _key_phase++;
+        if (calibrated && bright != _scaled_bright)
+            rescale();
+
+        uint32_t sum = 0;
+        for (auto i = 0U; i < n_leds; i++) {
+            if (dithered) {
+                auto v = apply_correction<gamma_corrected, dither_t::FRAC_BITS, calibrated>(interpolated(i), i);
+                fb[i] = dither(i, v);
+            } else {
+                fb[i] = apply_correction<gamma_corrected, 0, calibrated>(interpolated(i), i);
+            }
+            sum += fb[i];
+        }
+
+        // Scale the whole frame down if it's over the limit. One division per frame, and only when limiting.
+        if (sum > output_limit) {
+            const uint32_t scale = (output_limit << 8) / sum;
+            sum = 0;
+            for (auto& v : fb) {
+                v = (v * scale) >> 8;
+                sum += v;
+            }
+        }
+        _output_sum = sum;
+        return sum;
+    }
+
+protected:
+    // The frame as generated, word aligned for packed (several LEDs at a time) arithmetic on it, and the
+    // gamma-corrected and scaled output
+    alignas(4) fb_t buffer;
+    out_t out;
+    fb_t* _draw = nullptr;
+
+    // Per-LED error carried between frames when dithering the output
+    using dither_t = SigmaDelta<n_leds>;
+    dither_t dither;
+
+    // The keyframes being interpolated from and to, 2^_key_shift ticks apart. _key_phase counts ticks since the last
+    // one.
+    std::array<fb_t, 2> keyframes;
+    uint8_t _key_shift = 0;
+    uint8_t _key_phase = 1;
+
+    uint32_t _output_sum = 0;
+
+    // Each LED's output scale (its full scale less its offset) and offset, from bright and the calibration table. Only
+    // worked out again when either changes, so the correction multiplies by an LED's own scale where it would have
+    // multiplied by bright, at no extra cost.
+    struct led_scale_t {
+        uint16_t range, offset;
+    };
+    std::array<led_scale_t, n_leds> _scale;
+    uint16_t _scaled_bright;
+    std::array<led_cal_t, n_leds> _cal = default_cal();
+
+    // LED_CAL if it's for this many LEDs, otherwise no calibration
+    static constexpr std::array<led_cal_t, n_leds> default_cal()
+    {
+        std::array<led_cal_t, n_leds> cal {};
+        for (auto i = 0U; i < n_leds; i++)
+            cal[i] = n_leds == NUM_LEDS ? LED_CAL[i] : led_cal_t { 0xffff, 0 };
+        return cal;
+    }
+
+    void rescale()
+    {
+        for (auto i = 0U; i < n_leds; i++) {
+            auto c = _cal[i];
+            // gain + 1 so that 0xffff leaves bright as is
+            uint32_t full = (static_cast<uint32_t>(bright) * (c.gain + 1U)) >> 16;
+            uint32_t offset = (full * c.offset) >> 16;
+            _scale[i] = { static_cast<uint16_t>(full - offset), static_cast<uint16_t>(offset) };
+        }
+        _scaled_bright = bright;
+    }
+
+    // Value of LED i at the current interpolation phase. Shift and multiply only.
+    pixel_t interpolated(const uint8_t i) const
+    {
+        if (_key_shift == 0)
+            return keyframes[1][i];
+        int32_t delta = static_cast<int32_t>(keyframes[1][i]) - keyframes[0][i];
+        return keyframes[0][i] + ((delta * _key_phase) >> _key_shift);
+    }
+
+    // 8-bit pixels go through this instead of the float maths below
+    template <bool gamma_corrected> static constexpr auto EXPAND = expand::table<gamma_corrected>();
+
+    // Runtime ~1.4ms / frame or about 8% of frame time for 16-bit pixels. Pretty expensive in space.
+    // Returns the output value of LED i with frac_bits of fraction below the output LSB, for the dithering stage to
+    // consume. Uncalibrated, every LED is scaled by bright alone.
+    // The arithmetic is done in word_t and real_t so that the op counting test can substitute counting types (see
+    // OpCount.h).
+    template <bool gamma_corrected = true, uint8_t frac_bits = 0, bool calibrated = ENABLE_CALIBRATION,
+        class word_t = uint32_t, class real_t = float>
+    word_t apply_correction(const pixel_t val, const uint8_t i)
+    {
+        if (val == 0)
+            return 0; // Off is off
+
+        const uint16_t range = calibrated ? _scale[i].range : bright;
+        // A lit LED's output starts from its offset
+        auto lit = [&](const word_t v) -> word_t {
+            if constexpr (calibrated)
+                return (word_t(_scale[i].offset) << frac_bits) + v;
+            else
+                return v;
+        };
+
+        if constexpr (sizeof(pixel_t) == 1) {
+            // range + 1 so that full scale comes out as exactly range. Can't overflow, 0xffff * 0x10000 < 2^32.
+            return lit((word_t(EXPAND<gamma_corrected>[val]) * (range + 1U)) >> (16 - frac_bits));
+        }
+
+        const word_t out_max = word_t(range) << frac_bits;
+
+        if (gamma_corrected) {
+            // The following is equivalent to:>
+            // float y = std::pow(float(val) * (1.0F / LED_MAX), GAMMA);
+
+            // Transform from uint16 range to [-1,1], ChebyshevFit::x_to_u over [0,1]. Using * here instead of / saves
+            // 500b of flash since we avoid pulling in fdiv that can't be optimized out
+            real_t u = real_t(val) * (2.0F / LED_MAX) - 1.0F;
+            real_t y = (gamma_coeffs[0] + gamma_coeffs[1] * u + gamma_coeffs[2] * (2 * u * u - 1)
+                + gamma_coeffs[3] * (4 * u * u * u - 3 * u));
+
+            // The approximation can (and does) return values < 0 and > 1, so
+            // truncate cleanly
+            if (y > 1.0F)
+                return lit(out_max);
+            else if (y < 0.0F)
+                return lit(0);
+            else
+                return lit(word_t(y * out_max));
+        } else {
+            return lit((word_t(val) * range) >> (16 - frac_bits));
+        }
+    }
+
+public:
+    static constexpr auto gamma_coeffs = ChebyshevFit::fit<float>(
+        [](float x) constexpr->float { return gcem::pow(x, GAMMA); }, 0, 1);
+};
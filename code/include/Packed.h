@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// Frame arithmetic on several LEDs at a time: pixels packed into a uint32_t word as lanes, two uint16_t or four uint8_t
+// (see MBI5043's pixel type), the lowest LED in the lowest lane. The M0 has no SIMD instructions, so lanes are kept apart
+// with masks, and carries/borrows out of each lane are turned into saturation masks instead of branches.
+//
+// Every kernel takes the lane type as its first template parameter, T.
+namespace packed {
+// Words are read straight out of frame arrays
+using pair_t = uint32_t __attribute__((__may_alias__));
+
+template <class T> struct lanes {
+    static_assert(std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>, "Lanes are 8 or 16 bits");
+
+    static constexpr uint8_t BITS = 8 * sizeof(T);
+    static constexpr uint32_t MAX = std::numeric_limits<T>::max();
+    static constexpr uint32_t ONES = UINT32_MAX / MAX; // bottom bit of each lane
+    static constexpr uint32_t HI_BITS = ONES << (BITS - 1); // top bit of each lane
+};
+
+constexpr uint32_t BYTES = 0x00ff00ff; // every other byte: the low byte of each 16-bit lane, or the even 8-bit lanes
+
+// All lanes set to v
+template <class T> constexpr uint32_t splat(const T v) { return v * lanes<T>::ONES; }
+
+// All ones in each lane whose top bit is set in `bits` (which only has lane top bits set)
+template <class T> inline uint32_t lane_mask(const uint32_t bits)
+{
+    uint32_t m = bits >> (lanes<T>::BITS - 1);
+    return (m << lanes<T>::BITS) - m;
+}
+
+// Wrapping, like uint16_t/uint8_t arithmetic
+template <class T> inline uint32_t add(const uint32_t a, const uint32_t b)
+{
+    // Add the lanes without their top bits so nothing carries into the next lane, then put the top bits back
+    constexpr auto HI = lanes<T>::HI_BITS;
+    return ((a & ~HI) + (b & ~HI)) ^ ((a ^ b) & HI);
+}
+
+template <class T> inline uint32_t add_sat(const uint32_t a, const uint32_t b)
+{
+    uint32_t s = add<T>(a, b);
+    uint32_t carry = ((a & b) | ((a | b) & ~s)) & lanes<T>::HI_BITS;
+    return s | lane_mask<T>(carry);
+}
+
+template <class T> inline uint32_t sub_sat(const uint32_t a, const uint32_t b)
+{
+    constexpr auto HI = lanes<T>::HI_BITS;
+    uint32_t d = ((a | HI) - (b & ~HI)) ^ ((a ^ ~b) & HI);
+    uint32_t borrow = ((~a & b) | (~(a ^ b) & d)) & HI;
+    return d & ~lane_mask<T>(borrow);
+}
+
+// b + (a - b), where a > b, and b + 0 otherwise. Neither can carry out of a lane.
+template <class T> inline uint32_t max(const uint32_t a, const uint32_t b) { return b + sub_sat<T>(a, b); }
+template <class T> inline uint32_t min(const uint32_t a, const uint32_t b) { return a - sub_sat<T>(a, b); }
+
+// The byte split used by scale and lerp: `odd` is the odd bytes (the high byte of each 16-bit lane, or the odd 8-bit
+// lanes) times a factor 0-256, which leaves them in place. For 8-bit lanes the fraction that lands in the byte below
+// belongs to another lane, so it's masked off.
+template <class T> inline uint32_t odd_bytes(const uint32_t odd)
+{
+    return sizeof(T) == 1 ? odd & ~BYTES : odd;
+}
+
+// a * k / 256 in each lane, k 0-256. Split into bytes like lerp, 2 multiplies for the whole word.
+template <class T> inline uint32_t scale(const uint32_t a, const uint16_t k)
+{
+    return odd_bytes<T>(((a >> 8) & BYTES) * k) + ((((a & BYTES) * k) >> 8) & BYTES);
+}
+
+// a * b / (MAX + 1) in each lane, rounded so that multiplying by all ones leaves a unchanged. Needs a full multiply per
+// lane, so this one is a lane at a time.
+template <class T> inline uint32_t mul(const uint32_t a, const uint32_t b)
+{
+    constexpr auto BITS = lanes<T>::BITS, MAX = lanes<T>::MAX;
+    uint32_t r = 0;
+    for (auto s = 0U; s < 32; s += BITS)
+        r |= ((((a >> s) & MAX) * (((b >> s) & MAX) + 1)) >> BITS) << s;
+    return r;
+}
+
+// a + (b - a) * alpha / 256 in each lane, alpha 0-256. Each word is split into its odd and even bytes, whose products
+// with an 8-bit alpha fit in 16 bits, so 2 multiplies do the odd bytes and 2 more the even bytes.
+template <class T> inline uint32_t lerp(const uint32_t a, const uint32_t b, const uint16_t alpha)
+{
+    uint32_t hi = ((a >> 8) & BYTES) * (256 - alpha) + ((b >> 8) & BYTES) * alpha;
+    uint32_t lo = (((a & BYTES) * (256 - alpha) + (b & BYTES) * alpha) >> 8) & BYTES;
+    return odd_bytes<T>(hi) + lo;
+}
+
+// Whether a frame can be accessed as words
+template <class T, size_t n> bool aligned(const std::array<T, n>& fb)
+{
+    return !(reinterpret_cast<uintptr_t>(fb.data()) & 3);
+}
+
+// fb[i] = f(fb[i]) over a frame, a word at a time (if it's word aligned)
+template <class T, size_t n, class F> void apply(std::array<T, n>& fb, F f)
+{
+    constexpr auto PER_WORD = sizeof(uint32_t) / sizeof(T);
+    size_t i = 0;
+    if (aligned(fb)) {
+        // Spelled out, auto would drop the may_alias
+        pair_t* d = reinterpret_cast<pair_t*>(fb.data());
+        for (; i < n / PER_WORD; i++)
+            d[i] = f(d[i]);
+        i *= PER_WORD;
+    }
+    for (; i < n; i++)
+        fb[i] = f(fb[i]);
+}
+
+// dst[i] = f(dst[i], src[i]) over a frame, a word at a time. Both frames should be 4-byte aligned (word access to an
+// unaligned address faults on the M0), otherwise this goes a lane at a time. LEDs left over past the last whole word
+// are done on their own.
+template <class T, size_t n, class F> void apply(std::array<T, n>& dst, const std::array<T, n>& src, F f)
+{
+    constexpr auto PER_WORD = sizeof(uint32_t) / sizeof(T);
+    size_t i = 0;
+    if (aligned(dst) && aligned(src)) {
+        // Spelled out, auto would drop the may_alias
+        pair_t* d = reinterpret_cast<pair_t*>(dst.data());
+        const pair_t* s = reinterpret_cast<const pair_t*>(src.data());
+        for (; i < n / PER_WORD; i++)
+            d[i] = f(d[i], s[i]);
+        i *= PER_WORD;
+    }
+    for (; i < n; i++)
+        dst[i] = f(dst[i], src[i]);
+}
+}
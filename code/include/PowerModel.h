@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include "config.h"
+
+// Estimate supply current from what's actually being put on the LEDs. The MBI5043 is a constant current sink with PWM
+// dimming, so each channel draws (base current * gain) scaled by its output duty cycle, on top of a fixed overhead for
+// the driver's quiescent current and the MCU.
+//
+// Everything here is integer math with constant divisors so it's cheap enough to run every tick in the SysTick ISR.
+
+// Current gain in 1/1000ths for the MBI5043 configuration register gain bits. The datasheet gives 1/8x at 0 up to
+// 1.938x at the top of the range, assume it's linear in between.
+constexpr uint32_t mbi_gain_milli(const uint8_t gain) { return 125 + (1938 - 125) * gain / 0b111111; }
+
+struct PowerModel {
+    // Current of one channel driven at 100% duty
+    static constexpr uint32_t LED_FULL_UA = MBI_BASE_CURRENT_UA * mbi_gain_milli(MBI_GAIN) / 1000;
+
+    // Current that doesn't depend on the frame content
+    static constexpr uint32_t OVERHEAD_UA = MBI_QUIESCENT_UA + MCU_CURRENT_UA;
+
+    // LED current for a frame given the sum of its corrected output values. Scaled so the multiply fits in 32 bits for
+    // a full-on 16 channel driver at max gain; a 16-bit output value is 1/65536 of full duty, close enough.
+    static constexpr uint32_t led_ua(const uint32_t out_sum) { return ((out_sum >> 4) * LED_FULL_UA) >> 12; }
+
+    static constexpr uint32_t supply_ua(const uint32_t out_sum) { return OVERHEAD_UA + led_ua(out_sum); }
+
+    // Inverse of supply_ua: the largest output sum that stays within limit_ua, for the driver's output limiter
+    static constexpr uint32_t max_out_sum(const uint32_t limit_ua)
+    {
+        if (limit_ua == 0)
+            return UINT32_MAX; // limiting disabled
+        if (limit_ua <= OVERHEAD_UA)
+            return 0;
+        return ((limit_ua - OVERHEAD_UA) << 12) / LED_FULL_UA << 4;
+    }
+
+    // Account for one tick (1/FPS s) of output. The driver's quiescent current is saved while it's switched off.
+    void update(const uint32_t out_sum, const bool driver_powered = true)
+    {
+        charge += driver_powered ? supply_ua(out_sum) : MCU_CURRENT_UA;
+        ticks++;
+    }
+
+    // Average supply current since power on
+    uint32_t average_ua() const { return ticks ? charge / ticks : OVERHEAD_UA; }
+
+    // Charge used since power on. SRAM doesn't survive standby, so this only covers the current session.
+    uint32_t used_uah() const { return charge / (FPS * 3600); }
+
+    // Projected hours of battery left at the average current so far, assuming the cells were fresh at power on
+    uint32_t hours_remaining() const
+    {
+        constexpr uint32_t capacity_uah = BATTERY_CAPACITY_MAH * 1000;
+        auto used = used_uah();
+        return used >= capacity_uah ? 0 : (capacity_uah - used) / average_ua();
+    }
+
+    // Total charge in uA * ticks. 64 bits is good for far longer than a coin cell lasts.
+    uint64_t charge = 0;
+    uint32_t ticks = 0;
+};
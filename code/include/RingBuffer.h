@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed size FIFO for passing data between an interrupt handler and the main loop, one writer and one reader. Never
+// allocates; a push to a full buffer fails and is left to the caller to count. Size must be a power of 2 so wrapping
+// the indices is a mask, and one slot is sacrificed to tell full from empty.
+template <class T, size_t N> class RingBuffer {
+    static_assert(N && !(N & (N - 1)), "RingBuffer size must be a power of 2");
+
+public:
+    static constexpr size_t CAPACITY = N - 1;
+
+    bool push(const T v)
+    {
+        size_t next = (_head + 1) & (N - 1);
+        if (next == _tail)
+            return false;
+        _buf[_head] = v;
+        _head = next;
+        return true;
+    }
+
+    // Pop the oldest entry into `v`, false if empty
+    bool pop(T& v)
+    {
+        if (empty())
+            return false;
+        v = _buf[_tail];
+        _tail = (_tail + 1) & (N - 1);
+        return true;
+    }
+
+    bool empty() const { return _head == _tail; }
+    size_t size() const { return (_head - _tail) & (N - 1); }
+    size_t space() const { return CAPACITY - size(); }
+
+private:
+    std::array<T, N> _buf;
+    volatile size_t _head = 0, _tail = 0;
+};
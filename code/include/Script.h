@@ -0,0 +1,215 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "MBIEffect.h"
+#include "config.h"
+
+// A tiny bytecode for animations, so a new look is a few dozen bytes of flash instead of another template
+// instantiation. Scripts are compiled from text by tools/animc.cpp (see scripts/ for the syntax).
+//
+// Every LED has a value and optionally a ramp in progress towards a target. A script runs until it WAITs, then the
+// ramps advance one step and the frame is shown. Running off the end starts the script again. An effect rendered at a
+// fraction of the frame rate moves the VM on by the frames each call covers, skipping through WAITs and ramps.
+namespace script {
+enum op_t : uint8_t {
+    SET = 1, // led, value (u16): set immediately, cancelling any ramp
+    RAMP, // led, value (u16), frames (u8): ramp linearly to value, arriving after that many frames
+    WAIT, // frames (u8): show this many frames before continuing (0 is the same as 1)
+    LOOP, // count (u8): repeat up to the matching END count times, 0 for ever
+    END,
+    PICK, // n (u8): pick a random number 0..n-1, for PICKED LED operands
+};
+
+// LED operands are a physical LED number, ALL, or an index into LED_ORDER offset by the innermost loop's iteration
+// count (ORDER) or by the last PICK (PICKED), so a loop can walk the chase order
+constexpr uint8_t ALL = 0xff;
+constexpr uint8_t ORDER = 0x40;
+constexpr uint8_t PICKED = 0x80;
+constexpr uint8_t OFFSET_MASK = 0x3f;
+
+constexpr uint8_t MAX_DEPTH = 4; // nested loops
+constexpr uint8_t MAX_OPS = 64; // per frame, in case a script forgets to WAIT in a loop
+
+// Operand bytes following each op
+constexpr uint8_t operand_bytes(const uint8_t op)
+{
+    switch (op) {
+    case SET:
+        return 3;
+    case RAMP:
+        return 4;
+    case WAIT:
+    case LOOP:
+    case PICK:
+        return 1;
+    default:
+        return 0;
+    }
+}
+}
+
+// Interpreter state. Only one effect runs at a time, so all scripts share one of these rather than each carrying the
+// RAM for it. Ramps are worked out in word_t, for counting (OpCount.h).
+template <uint8_t n_leds, class word_t = int32_t> struct ScriptVM {
+    struct loop_t {
+        uint16_t start;
+        uint8_t count; // 0 for ever
+        uint8_t i; // iteration, wraps at the length of LED_ORDER in endless loops
+    };
+
+    const uint8_t* code = nullptr;
+    uint16_t len = 0, pc = 0;
+    uint8_t wait = 0, depth = 0, picked = 0;
+    std::array<loop_t, script::MAX_DEPTH> loops {};
+
+    std::array<uint16_t, n_leds> value {}, target {};
+    // Ramps in progress: frames to go, and the change per frame in 1/256ths, worked out when the ramp starts so a
+    // frame is adds only (no divider on the M0). frac carries the fraction of value between frames.
+    std::array<uint8_t, n_leds> ramp_left {}, frac {};
+    std::array<int32_t, n_leds> ramp_step {};
+
+    void load(const uint8_t* c, const uint16_t l)
+    {
+        *this = ScriptVM();
+        code = c;
+        len = l;
+    }
+
+    // Work out the frame n frames on into `value`
+    void frame(uint16_t n = 1)
+    {
+        while (n) {
+            uint16_t k = 1;
+            if (wait) {
+                k = std::min<uint16_t>(n, wait);
+                wait -= k;
+            } else {
+                run();
+            }
+            step(k);
+            n -= k;
+        }
+    }
+
+    // Execute up to the next WAIT
+    void run()
+    {
+        for (auto n = 0U; n < script::MAX_OPS; n++) {
+            if (pc >= len) {
+                pc = 0;
+                depth = 0;
+            }
+            auto op = code[pc];
+            auto arg = code + pc + 1;
+            pc += 1 + script::operand_bytes(op);
+
+            switch (op) {
+            case script::SET:
+            case script::RAMP: {
+                uint16_t v = arg[1] | arg[2] << 8;
+                uint8_t frames = op == script::RAMP ? arg[3] : 0;
+                for_leds(arg[0], [&](uint8_t led) {
+                    target[led] = v;
+                    ramp_left[led] = frames;
+                    frac[led] = 0;
+                    if (frames)
+                        ramp_step[led] = static_cast<int32_t>((word_t(v) - value[led]) * 256 / frames);
+                    else
+                        value[led] = v;
+                });
+                break;
+            }
+            case script::WAIT:
+                wait = arg[0] ? arg[0] - 1 : 0;
+                return;
+            case script::LOOP:
+                if (depth < loops.size())
+                    loops[depth++] = { pc, arg[0], 0 };
+                break;
+            case script::END: {
+                if (!depth)
+                    break;
+                auto& l = loops[depth - 1];
+                l.i++;
+                if (!l.count && l.i == LED_ORDER.size())
+                    l.i = 0;
+                if (!l.count || l.i < l.count)
+                    pc = l.start;
+                else
+                    depth--;
+                break;
+            }
+            case script::PICK:
+                picked = arg[0] ? static_cast<uint8_t>(effect_rng() % word_t(arg[0])) : 0;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    // Advance ramps k frames
+    void step(const uint16_t k = 1)
+    {
+        for (auto i = 0U; i < n_leds; i++) {
+            if (!ramp_left[i])
+                continue;
+            if (k >= ramp_left[i]) {
+                // Exactly on target, whatever the rounding on the way
+                value[i] = target[i];
+                ramp_left[i] = 0;
+            } else {
+                word_t v = (word_t(value[i]) << 8 | frac[i]) + word_t(ramp_step[i]) * k;
+                value[i] = static_cast<uint16_t>(v >> 8);
+                frac[i] = static_cast<uint8_t>(v & 0xff);
+                ramp_left[i] -= k;
+            }
+        }
+    }
+
+private:
+    template <class F> void for_leds(const uint8_t led, F f)
+    {
+        if (led == script::ALL) {
+            for (auto i = 0U; i < n_leds; i++)
+                f(i);
+            return;
+        }
+        uint8_t i = led;
+        if (led & (script::ORDER | script::PICKED)) {
+            uint8_t base = led & script::PICKED ? picked : depth ? loops[depth - 1].i : 0;
+            i = LED_ORDER[(base + (led & script::OFFSET_MASK)) % LED_ORDER.size()];
+        }
+        if (i < n_leds)
+            f(i);
+    }
+};
+
+// Effect running a compiled script
+template <class MBI> struct Script : MBIEffect<MBI> {
+    template <size_t len>
+    constexpr Script(const uint8_t (&code)[len])
+        : _code(code)
+        , _len(len)
+    {
+    }
+
+    void operator()(MBI& mbi, const uint32_t)
+    {
+        // Start from the top whenever we take over from another script
+        if (vm.code != _code)
+            vm.load(_code, _len);
+
+        vm.frame(this->frames_per_call());
+        from16<MBI>(mbi.get_buffer(), vm.value);
+    }
+
+    static inline ScriptVM<MBI::N_LEDS> vm;
+
+private:
+    const uint8_t* _code;
+    uint16_t _len;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+// Generated by tools/animc.cpp from scripts/, don't edit. To regenerate, from the code/ directory:
+//   ./animc scripts/*.anim > include/Scripts.h
+
+#include <cstdint>
+
+namespace scripts {
+constexpr uint8_t breathe[] = {
+    4, 0, 2, 255, 255, 255, 90, 3, 90, 2, 255, 208, 7, 90, 3, 90,
+    5,
+};
+constexpr uint8_t comet[] = {
+    1, 255, 0, 0, 4, 0, 2, 64, 255, 255, 6, 2, 77, 32, 78, 6,
+    2, 76, 0, 0, 12, 3, 6, 5,
+};
+constexpr uint8_t heartbeat[] = {
+    1, 255, 0, 0, 4, 0, 2, 255, 255, 255, 4, 3, 4, 2, 255, 64,
+    31, 8, 3, 10, 2, 255, 255, 127, 4, 3, 4, 2, 255, 0, 0, 20,
+    3, 50, 5,
+};
+constexpr uint8_t sparkle[] = {
+    2, 255, 184, 11, 30, 3, 30, 4, 0, 6, 14, 1, 128, 255, 255, 2,
+    128, 184, 11, 40, 3, 7, 5,
+};
+constexpr uint8_t wipe[] = {
+    1, 255, 0, 0, 4, 0, 4, 14, 2, 64, 255, 255, 10, 3, 4, 5,
+    3, 30, 4, 14, 2, 64, 0, 0, 10, 3, 4, 5, 3, 30, 5,
+};
+}
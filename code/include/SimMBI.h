@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+// Stand-in for MBI5043 with just the frame buffer, for running effects on a PC (tools/, tests). Effects only touch the
+// driver through get_buffer() & co, so they run unmodified against it.
+template <uint8_t n_leds, class px_t = uint16_t> struct SimMBI {
+    static constexpr uint16_t LED_MAX = std::numeric_limits<px_t>::max();
+    static constexpr uint16_t LED_MIN = 0x0000;
+    static constexpr auto N_LEDS = n_leds;
+
+    using pixel_t = px_t;
+    using fb_t = std::array<pixel_t, n_leds>;
+
+    fb_t& get_buffer() { return _draw ? *_draw : buffer; }
+    fb_t* draw_to(fb_t* fb)
+    {
+        auto prev = _draw;
+        _draw = fb;
+        return prev;
+    }
+    const fb_t& cur_frame() const { return buffer; }
+    void clear_buffers() { buffer.fill(0); }
+
+    alignas(4) fb_t buffer {};
+
+private:
+    fb_t* _draw = nullptr;
+};
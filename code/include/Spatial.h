@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+
+#include "Geometry.h"
+#include "MBIEffect.h"
+
+// Effects driven by where the LEDs are on the board rather than by their order. All the geometry is worked out at
+// compile time into flash tables (Geometry.h), none of it is done per frame.
+
+// Triangle wave over a 16-bit phase: off at 0, (just under) full on halfway round
+template <class MBI> inline typename MBI::pixel_t triangle(const uint16_t phase)
+{
+    uint32_t t = (phase & 0x8000 ? ~phase : phase) & 0x7fff;
+    return (t * (MBI::LED_MAX + 1U)) >> 15;
+}
+
+// Waves travelling across one of the geometry tables: each LED shows a triangle wave delayed by its entry in `field`.
+// With geometry::DIST rings pulse out from the centre, with ANGLE a beam sweeps round it, with X or Y bands sweep
+// across the board. `waves` is how many wavelengths fit across the field, period how many frames a wave takes to pass
+// a point (negative to run the other way).
+template <class MBI> struct Wave : MBIEffect<MBI> {
+    using field_t = std::array<uint8_t, MBI::N_LEDS>;
+
+    Wave(const field_t& field, const int16_t period, const uint8_t waves = 1)
+        : _field(field)
+        , _step(0x10000 / period)
+        , _spread(waves << 8)
+    {
+    }
+
+    // A table load, a subtract and the triangle per LED, like Chase
+    void operator()(MBI& mbi, const uint32_t frames)
+    {
+        auto& fb = mbi.get_buffer();
+        uint16_t phase = frames * _step;
+        for (auto i = 0U; i < MBI::N_LEDS; i++)
+            fb[i] = triangle<MBI>(phase - _field[i] * _spread);
+    }
+
+private:
+    const field_t& _field;
+    int16_t _step;
+    uint16_t _spread;
+};
+
+// Bursts of light at random LEDs every `interval` frames, spreading out to their neighbours. Each LED rises by `rise`
+// a frame towards its brightest neighbour less `drop`, so the burst travels outwards getting dimmer, and once it's
+// there fades by `fade` a frame. A compare per neighbour (geometry::NEIGHBOURS), so several times Chase's cost.
+// Called less often than every frame, it rises and fades by the frames covered, but still spreads a neighbour a call.
+// word_t is the type the LEDs are worked out in, for counting (OpCount.h).
+template <class MBI, class word_t = int32_t> struct StarBurst : MBIEffect<MBI> {
+    StarBurst(const uint16_t interval, const uint16_t rise, const uint16_t fade, const uint16_t drop)
+        : _interval(interval)
+        , _rise(rise)
+        , _fade(fade)
+        , _drop(drop)
+    {
+    }
+
+    void operator()(MBI& mbi, const uint32_t)
+    {
+        auto& fb = mbi.get_buffer();
+        const auto prev = fb;
+        const word_t rise = word_t(_rise) << this->frame_shift;
+        const word_t fade = word_t(_fade) << this->frame_shift;
+        for (auto i = 0U; i < MBI::N_LEDS; i++) {
+            word_t target = 0;
+            for (auto n : geometry::NEIGHBOURS[i])
+                target = std::max<word_t>(target, prev[n]);
+            target -= _drop;
+
+            word_t v = prev[i];
+            if (v >= target)
+                v = std::max<word_t>(v - fade, 0);
+            else
+                v = std::min<word_t>(v + rise, target);
+            fb[i] = static_cast<typename MBI::pixel_t>(v);
+        }
+
+        if (_frames_left <= 0) {
+            fb[std::uniform_int_distribution<uint8_t>(0, MBI::N_LEDS - 1)(effect_rng)] = MBI::LED_MAX;
+            _frames_left += _interval;
+        }
+        _frames_left -= this->frames_per_call();
+    }
+
+private:
+    uint16_t _interval, _rise, _fade, _drop;
+    int16_t _frames_left = 0;
+};
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "config.h"
+
+// Binary protocol for streaming frames from a host over the UART. Every packet is
+//
+//   SYNC | type | payload | CRC16 (CCITT, over type and payload)
+//
+// with all multi-byte fields little endian. A KEY packet carries every LED's value. A DELTA packet carries a bitmask
+// of the LEDs that changed since the previous frame, then the new value of each one in LED order, so a frame where only
+// a few LEDs move costs a few bytes. A full KEY packet for 11 LEDs is 26 bytes, ~440 packets/s at 115200 baud. A CAL
+// packet carries a calibration table to try out (each LED's gain then offset, see LED_CAL), rather than a frame.
+//
+// Deltas only make sense applied to the frame the sender thinks we have, so after any lost or corrupt packet deltas are
+// ignored until the next KEY. Senders should send one every so often (StreamEncoder::KEY_INTERVAL).
+namespace stream {
+constexpr uint8_t SYNC = 0xa5;
+enum type_t : uint8_t { KEY = 'K', DELTA = 'D', CAL = 'C' };
+
+constexpr uint16_t crc16(uint16_t crc, const uint8_t b)
+{
+    crc ^= static_cast<uint16_t>(b) << 8;
+    for (auto i = 0; i < 8; i++)
+        crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    return crc;
+}
+constexpr uint16_t CRC_INIT = 0xffff;
+
+// Largest packet for n_leds LEDs, a CAL
+constexpr size_t max_packet(const size_t n_leds) { return 1 + 1 + 4 * n_leds + 2; }
+}
+
+// Reassemble frames from the byte stream, one byte at a time (from the RX interrupt's buffer on target)
+template <uint8_t n_leds> class StreamDecoder {
+    static_assert(n_leds <= 16, "DELTA masks are 16 bits");
+
+public:
+    using frame_t = std::array<uint16_t, n_leds>;
+    using cal_t = std::array<led_cal_t, n_leds>;
+
+    // Feed the next received byte. Returns true when it completes a packet that updated frame().
+    bool feed(const uint8_t b)
+    {
+        switch (_state) {
+        case SYNC:
+            if (b == stream::SYNC)
+                _state = TYPE;
+            return false;
+        case TYPE:
+            if (b != stream::KEY && b != stream::DELTA && b != stream::CAL) {
+                lost();
+                return false;
+            }
+            _type = static_cast<stream::type_t>(b);
+            _crc = stream::crc16(stream::CRC_INIT, b);
+            _len = 0;
+            _need = b == stream::KEY ? 2 * n_leds : b == stream::CAL ? 4 * n_leds : 2;
+            _state = PAYLOAD;
+            return false;
+        case PAYLOAD:
+            _crc = stream::crc16(_crc, b);
+            _payload[_len++] = b;
+            // The mask says how long the rest of a DELTA is
+            if (_type == stream::DELTA && _len == 2)
+                _need = 2 + 2 * __builtin_popcount(u16(0) & MASK);
+            if (_len == _need)
+                _state = CRC_LO;
+            return false;
+        case CRC_LO:
+            _rx_crc = b;
+            _state = CRC_HI;
+            return false;
+        case CRC_HI:
+            _state = SYNC;
+            if ((_rx_crc | b << 8) != _crc) {
+                lost();
+                return false;
+            }
+            return apply();
+        }
+        return false;
+    }
+
+    const frame_t& frame() const { return _frame; }
+
+    // The calibration table received since the last call, nullptr if none
+    const cal_t* take_cal()
+    {
+        if (!_new_cal)
+            return nullptr;
+        _new_cal = false;
+        return &_cal;
+    }
+
+    // Packets dropped for a bad CRC or type
+    uint32_t errors = 0;
+
+private:
+    static constexpr uint16_t MASK = (1U << n_leds) - 1;
+
+    uint16_t u16(const size_t ofs) const { return _payload[ofs] | _payload[ofs + 1] << 8; }
+
+    void lost()
+    {
+        errors++;
+        _synced = false;
+        _state = SYNC;
+    }
+
+    bool apply()
+    {
+        if (_type == stream::CAL) {
+            for (auto i = 0U; i < n_leds; i++)
+                _cal[i] = { u16(4 * i), u16(4 * i + 2) };
+            _new_cal = true;
+            return false;
+        }
+        if (_type == stream::KEY) {
+            for (auto i = 0U; i < n_leds; i++)
+                _frame[i] = u16(2 * i);
+            _synced = true;
+            return true;
+        }
+        if (!_synced)
+            return false;
+        uint16_t mask = u16(0) & MASK;
+        for (size_t i = 0, ofs = 2; mask; i++, mask >>= 1) {
+            if (mask & 1) {
+                _frame[i] = u16(ofs);
+                ofs += 2;
+            }
+        }
+        return true;
+    }
+
+    enum { SYNC, TYPE, PAYLOAD, CRC_LO, CRC_HI } _state = SYNC;
+    stream::type_t _type = stream::KEY;
+    std::array<uint8_t, stream::max_packet(n_leds)> _payload;
+    uint8_t _len = 0, _need = 0, _rx_crc = 0;
+    uint16_t _crc = 0;
+    bool _synced = false, _new_cal = false;
+    frame_t _frame {};
+    cal_t _cal;
+};
+
+// Host side: turn a sequence of frames into packets, a DELTA when it's smaller and a KEY every KEY_INTERVAL frames so a
+// receiver that lost a packet picks up again
+template <uint8_t n_leds> class StreamEncoder {
+public:
+    using frame_t = std::array<uint16_t, n_leds>;
+    using cal_t = std::array<led_cal_t, n_leds>;
+    using packet_t = std::array<uint8_t, stream::max_packet(n_leds)>;
+
+    static constexpr uint32_t KEY_INTERVAL = 30;
+
+    // Encode `frame` into `out`, returns the packet length
+    size_t encode(const frame_t& frame, packet_t& out)
+    {
+        uint16_t mask = 0;
+        for (auto i = 0U; i < n_leds; i++)
+            if (frame[i] != _prev[i])
+                mask |= 1U << i;
+
+        bool key = _count++ % KEY_INTERVAL == 0 || 2 + 2 * __builtin_popcount(mask) >= 2 * n_leds;
+        size_t len = 0;
+        out[len++] = stream::SYNC;
+        out[len++] = key ? stream::KEY : stream::DELTA;
+        if (key) {
+            for (auto v : frame)
+                put16(out, len, v);
+        } else {
+            put16(out, len, mask);
+            for (auto i = 0U; i < n_leds; i++)
+                if (mask & 1U << i)
+                    put16(out, len, frame[i]);
+        }
+        seal(out, len);
+
+        _prev = frame;
+        return len;
+    }
+
+    // Encode a calibration table into `out`, returns the packet length. Doesn't affect the frames.
+    static size_t encode_cal(const cal_t& cal, packet_t& out)
+    {
+        size_t len = 0;
+        out[len++] = stream::SYNC;
+        out[len++] = stream::CAL;
+        for (auto& c : cal) {
+            put16(out, len, c.gain);
+            put16(out, len, c.offset);
+        }
+        seal(out, len);
+        return len;
+    }
+
+private:
+    frame_t _prev {};
+    uint32_t _count = 0;
+
+    static void put16(packet_t& out, size_t& len, const uint16_t v)
+    {
+        out[len++] = v & 0xff;
+        out[len++] = v >> 8;
+    }
+
+    // Append the CRC of everything after SYNC
+    static void seal(packet_t& out, size_t& len)
+    {
+        uint16_t crc = stream::CRC_INIT;
+        for (auto i = 1U; i < len; i++)
+            crc = stream::crc16(crc, out[i]);
+        put16(out, len, crc);
+    }
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "config.h"
+
+// Trade display quality for run time as the cells sag. Supply samples are smoothed (LED load transients and the coin
+// cells' recovery when the load drops make them jumpy), then mapped onto a level with hysteresis so we don't flap
+// between levels on the boundary. Each level caps the brightness setting, renders fewer keyframes and slows the clock,
+// though only as far as CLK_DIV_MAX, so the lowest levels save by brightness and keyframe rate alone.
+struct SupplyGovernor {
+    struct level_t {
+        uint8_t max_bright; // highest cur_bright index allowed
+        uint8_t keyframe_shift; // render keyframes 2^keyframe_shift times less often
+        uint8_t clk_div; // divide SYSCLK by this
+    };
+
+    // Level 0 is full quality, each following level applies below the corresponding SUPPLY_LEVELS_MV threshold
+    static constexpr std::array<level_t, SUPPLY_LEVELS_MV.size() + 1> LEVELS = { {
+        { 6, 0, 1 },
+        { 5, 0, 2 },
+        { 4, 1, 2 },
+        { 3, 2, 2 },
+    } };
+    static_assert([] {
+        for (auto& l : LEVELS)
+            if (l.clk_div > CLK_DIV_MAX)
+                return false;
+        return true;
+    }(), "GCLK can't keep up with the core divided further than CLK_DIV_MAX");
+
+    // Smoothing of supply samples, as a shift (1/2^n of each new sample is mixed in)
+    static constexpr uint8_t FILTER_SHIFT = 2;
+
+    // Feed a new supply sample, returns the current level
+    const level_t& update(const uint16_t mv)
+    {
+        if (!filtered_mv)
+            filtered_mv = mv << FILTER_SHIFT; // first sample, don't ramp up from 0
+        else
+            filtered_mv += mv - (filtered_mv >> FILTER_SHIFT);
+
+        auto v = supply_mv();
+        // Step down (possibly several levels) as soon as we cross a threshold
+        while (level < SUPPLY_LEVELS_MV.size() && v < SUPPLY_LEVELS_MV[level])
+            level++;
+        // Only step back up once we're clear of the threshold by the hysteresis margin
+        while (level > 0 && v >= SUPPLY_LEVELS_MV[level - 1] + SUPPLY_HYSTERESIS_MV)
+            level--;
+
+        return LEVELS[level];
+    }
+
+    uint16_t supply_mv() const { return filtered_mv >> FILTER_SHIFT; }
+    const level_t& current() const { return LEVELS[level]; }
+
+    uint32_t filtered_mv = 0;
+    uint8_t level = 0;
+};
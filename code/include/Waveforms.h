@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+#include "Fixed.h"
+#include "Geometry.h"
+#include "MBIEffect.h"
+
+// Effects built from smooth curves (Fixed.h) rather than linear ramps. All integer, a table lookup or two per LED.
+
+// The whole board breathing: brightness follows e^sin(t), scaled to 0-1, which lingers dim and swells quickly like
+// breathing does. The curve is worked out once a frame and copied to every LED.
+template <class MBI> struct Breathe : MBIEffect<MBI> {
+    Breathe(const uint16_t period)
+        : _step(0x10000 / period)
+    {
+    }
+
+    void operator()(MBI& mbi, const uint32_t frames)
+    {
+        constexpr auto lo = fixed::q16::from(1 / 2.718281828459045);
+        constexpr auto scale = fixed::q16::from(1 / (2.718281828459045 - 1 / 2.718281828459045));
+        auto v = (fixed::exp(fixed::q16::from(fixed::sin(frames * _step))) - lo) * scale;
+        mbi.get_buffer().fill(from16<MBI>(std::clamp<int32_t>(v.raw, 0, UINT16_MAX)));
+    }
+
+private:
+    uint16_t _step;
+};
+
+// Sines running across and down the board at different speeds, added together. The sum wanders about slowly without
+// ever quite repeating (over a minute, anyway). Periods in frames, negative to run the other way.
+template <class MBI> struct Plasma : MBIEffect<MBI> {
+    Plasma(const int16_t period_x, const int16_t period_y)
+        : _step_x(0x10000 / period_x)
+        , _step_y(0x10000 / period_y)
+    {
+    }
+
+    void operator()(MBI& mbi, const uint32_t frames)
+    {
+        auto& fb = mbi.get_buffer();
+        uint16_t px = frames * _step_x, py = frames * _step_y;
+        for (auto i = 0U; i < MBI::N_LEDS; i++) {
+            // Two Q1.15 values, so -65536 to 65534
+            int32_t sum = fixed::sin(px + (geometry::X[i] << 8)).raw + fixed::sin(py + (geometry::Y[i] << 8)).raw;
+            fb[i] = from16<MBI>((sum + 0x10000) >> 1);
+        }
+    }
+
+private:
+    int16_t _step_x, _step_y;
+};
+
+// A smooth version of Chase: a sine wave along the LED order, clipped at 0 and squared to narrow the peaks. LEDs that
+// appear in the order more than once show the brighter of their places.
+template <class MBI, class iter> struct SineChase : MBIEffect<MBI> {
+    SineChase(const iter begin, const iter end, const int16_t period, const uint8_t waves = 1)
+        : _begin(begin)
+        , _end(end)
+        , _step(0x10000 / period)
+        , _spacing(0x10000 * waves / std::distance(begin, end))
+    {
+    }
+
+    void operator()(MBI& mbi, const uint32_t frames)
+    {
+        auto& fb = mbi.get_buffer();
+        fb.fill(0);
+        uint16_t phase = frames * _step;
+        for (auto it = _begin; it != _end; it++, phase -= _spacing) {
+            auto s = fixed::sin(phase);
+            if (s.raw <= 0)
+                continue;
+            auto v = from16<MBI>((s * s).raw << 1);
+            fb[*it] = std::max(fb[*it], v);
+        }
+    }
+
+private:
+    const iter _begin, _end;
+    int16_t _step;
+    uint16_t _spacing;
+};
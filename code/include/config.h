@@ -1,11 +1,21 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
 
+// Native (unit test) builds only need the platform independent constants
+#if defined(STM32F0) || defined(STM32F1)
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/stm32/exti.h>
 #include <libopencm3/stm32/gpio.h>
 #include <libopencm3/stm32/pwr.h>
 #include <libopencm3/stm32/rcc.h>
 #include <libopencm3/stm32/timer.h>
+#else
+// Comes from the board definition on target
+#define F_CPU 8000000L
+#endif
 
 // Enable serial debug outputs
 // constexpr auto DEBUG
@@ -19,14 +29,49 @@
 // UART baud rate
 constexpr auto UART_SPEED = 115200;
 
+// Show frames streamed from a host over the UART (see Stream.h, tools/stream_send.cpp) in place of the local effects.
+// Off by default: it keeps USART1 clocked and its receive interrupt armed, which a card on a coin cell can do without.
+constexpr bool ENABLE_STREAM = false;
+
 // Number of LEDs attached to MBI
 constexpr auto NUM_LEDS = 11;
 
+// Frame buffer pixel depth, uint16_t or uint8_t. 8-bit frames take half the RAM (32 bytes less in the driver for 11
+// LEDs, and 12 per compositor layer), and the output stage corrects them with one table load per LED instead of float
+// maths (see Expand.h). Slow fades step visibly at 8 bits, dithering smooths the output but can't add precision the
+// effect didn't have.
+using fb_pixel_t = uint16_t;
+
 // Maximum LED brightness value. Appled at output, doesn't affect effects
 constexpr uint16_t LED_OUT_MAX = 65535;
 
 // MBI current gain. See datasheet page 16. 0 = 1/8x, 0b11111 = 1.938x. R4 (2.7k) sets the base value to 5.2mA
 constexpr uint8_t MBI_GAIN = 0;
+constexpr uint32_t MBI_BASE_CURRENT_UA = 5200;
+
+// Supply current model (see PowerModel.h). The MBI5043 draws multiple mA quiescent whether or not the LEDs are lit, and
+// the MCU spends most of each frame asleep. These are tuned so the model agrees with the 4-7mA measured on the card.
+constexpr uint32_t MBI_QUIESCENT_UA = 3500;
+constexpr uint32_t MCU_CURRENT_UA = 700;
+// How the MCU's sleep current scales with the core clock (peripherals clocked), roughly from the datasheet. Used to
+// estimate what running at a lower clock saves.
+constexpr uint32_t MCU_SLEEP_UA_PER_MHZ = 110;
+// Most the core clock may be divided down by. GCLK comes from it through a timer whose prescaler (2 at full speed) can
+// take up one halving; any more and GCLK drops below the 65536 * 60 = 3.93MHz a full PWM cycle per frame needs.
+constexpr uint8_t CLK_DIV_MAX = 2;
+
+// Usable capacity of the CR2032 cells, for battery life projection
+constexpr uint32_t BATTERY_CAPACITY_MAH = 220;
+
+// Supply voltage thresholds (mV, descending) where SupplyGovernor steps down to the next quality level. The MBI5043 is
+// only specified down to 3.0V, below that it starts dropping out.
+constexpr std::array<uint16_t, 3> SUPPLY_LEVELS_MV = { 3200, 3100, 3000 };
+// How far over a threshold the supply has to recover before stepping back up
+constexpr uint16_t SUPPLY_HYSTERESIS_MV = 50;
+
+// Cap on supply current. If the estimate for a frame exceeds this, the output is scaled down to fit, so the average
+// can never exceed it either. 0 to disable.
+constexpr uint32_t CURRENT_LIMIT_UA = 0;
 
 // Frames to draw per second
 constexpr auto FPS = 60;
@@ -39,29 +84,102 @@ constexpr size_t PWR_PRESS = FPS * 3; // 3s
 
 // Debounce delay after button input before accepting another input
 constexpr size_t DEBOUNCE_DELAY = FPS / 20; // ~50ms
+// The button is sampled by a timer this long after its last edge
+constexpr uint32_t DEBOUNCE_MS = DEBOUNCE_DELAY * 1000 / FPS;
+
+// How often to sample the supply voltage
+constexpr uint32_t SUPPLY_SAMPLE_FRAMES = FPS * 5; // 5s
+
+// Divide the core clock down as far as the running effect allows (see ClockGovernor.h), keeping this much headroom
+// over the most expensive recent frame
+constexpr bool CLOCK_SCALING = true;
+constexpr uint32_t CLOCK_MARGIN_PCT = 50;
+
+// When the main loop can't draw frames in time, step quality down (see DeadlineGovernor.h) after this many late ticks
+// within DEADLINE_WINDOW_FRAMES: halve the effect's keyframe rate up to DEADLINE_MAX_SHIFT times, then switch effects.
+// The rate is stepped back up after DEADLINE_RECOVER_FRAMES without a late tick.
+constexpr uint16_t DEADLINE_LATE_LIMIT = 3;
+constexpr uint32_t DEADLINE_WINDOW_FRAMES = FPS * 2;
+constexpr uint8_t DEADLINE_MAX_SHIFT = 2;
+constexpr uint32_t DEADLINE_RECOVER_FRAMES = FPS * 30;
+
+// Go back to the local effects when no streamed frame has arrived for this long
+constexpr uint32_t STREAM_TIMEOUT_FRAMES = FPS / 2;
 
 // Auto power off delay after no input
 constexpr uint32_t APO_FRAMES = FPS * 4 * 3600; // 4 hours
 
+// Stop the MBI5043's GCLK after this many consecutive all-dark frames (e.g. power off countdown, dark phases of
+// effects), and optionally cut its power too. It's brought back up as soon as a frame has anything lit. 0 to disable.
+constexpr uint16_t MBI_DARK_FRAMES = FPS / 4;
+constexpr bool MBI_DARK_POWER_OFF = true;
+// Time for the MBI5043 to come out of reset after its supply is switched back on
+constexpr uint32_t MBI_POWER_UP_US = 50;
+
 // LED chase order (zig-zag starting bottom right) - cap at NUM_LEDS for one
 // direction NOTE TO SELF: Next time make the Dx numbers match the output pin
 // numbers 🤦
 [[maybe_unused]] constexpr std::array LED_ORDER
     = { 3U, 4U, 5U, 6U, 7U, 8U, 9U, 10U, 1U, 0U, 2U, 8U, 9U, 10U };
 
+// Where each LED (by buffer index) is on the board, as drawn in doc/led indices.svg: x to the right, y down, in that
+// drawing's units (~0.26mm). Spatial effects work from tables computed from these at compile time (see Geometry.h).
+struct led_pos_t {
+    int16_t x, y;
+};
+[[maybe_unused]] constexpr std::array<led_pos_t, NUM_LEDS> LED_POS = { {
+    { 93, 43 }, // 0, top
+    { 130, 95 }, // 1
+    { 21, 80 }, // 2
+    { 170, 314 }, // 3, bottom right
+    { 52, 332 }, // 4, bottom left
+    { 95, 281 }, // 5, the three in the middle of the bottom, lowest first
+    { 94, 272 }, // 6
+    { 94, 264 }, // 7
+    { 71, 220 }, // 8, across the waist from left to right
+    { 90, 208 }, // 9
+    { 107, 197 }, // 10
+} };
+
+// Per-LED calibration, to even out the LEDs' differing efficacy. Applied in the output stage, along with gamma and
+// brightness (see OutputStage::rescale), so effects don't need to know about it. gain scales the LED's output,
+// 0xffff is as is. offset is where a lit LED's output starts from, as a fraction of its full scale in 1/65536ths, for
+// LEDs that need more current to visibly light. Measured values go here; a host can also send a table to try over
+// the UART (see Stream.h), which lasts until power off.
+struct led_cal_t {
+    uint16_t gain, offset;
+};
+[[maybe_unused]] constexpr std::array<led_cal_t, NUM_LEDS> LED_CAL = { {
+    { 0xffff, 0 },
+    { 0xffff, 0 },
+    { 0xffff, 0 },
+    { 0xffff, 0 },
+    { 0xffff, 0 },
+    { 0xffff, 0 },
+    { 0xffff, 0 },
+    { 0xffff, 0 },
+    { 0xffff, 0 },
+    { 0xffff, 0 },
+    { 0xffff, 0 },
+} };
+
 //
 constexpr bool ENABLE_GAMMA = true;
 // Gamma correction exponent
 constexpr float GAMMA = 2.8;
 // Gamma correction estimation degree/accuracy (only 3 supported for now)
 constexpr int GAMMA_DEGREE = 3;
+// Temporally dither the corrected output so slow fades at low brightness don't visibly step between output codes
+constexpr bool ENABLE_DITHER = true;
+// Apply the per-LED calibration (LED_CAL) at output
+constexpr bool ENABLE_CALIBRATION = true;
 
 // Platform specific configurationf follows (pin/timer setup)
 
 // Default hardware platform is STM32F0
 #ifdef STM32F0
 // IO layout:
-//   PA0  : input/WKUP <- PWR switch
+//   PA0  : input/WKUP <- PWR switch (EXTI0, debounced with TIM16)
 //   PA1  : n/c
 //   PA2  : unusable   -- Bodged to PA7 which has a working timer output
 //   PA3  : n/c
@@ -81,6 +199,13 @@ constexpr auto GPIO_PORT = GPIOA;
 
 constexpr auto PWR_SW = GPIO0;
 constexpr auto PWR_SW_WKUP = PWR_CSR_EWUP1;
+constexpr auto PWR_SW_EXTI = EXTI0;
+constexpr auto PWR_SW_EXTI_IRQ = NVIC_EXTI0_1_IRQ;
+
+// One-shot timer for button debounce
+constexpr auto BUTTON_TIMER = TIM16;
+constexpr auto BUTTON_TIMER_RCC = RCC_TIM16;
+constexpr auto BUTTON_TIMER_IRQ = NVIC_TIM16_IRQ;
 
 // NB: This isn't actually generalized since we are not capturing the AF setting here
 constexpr auto MBI_GCLK = GPIO7;
@@ -107,6 +232,12 @@ constexpr auto GPIO_PORT = GPIOA;
 
 constexpr auto PWR_SW = GPIO0;
 constexpr auto PWR_SW_WKUP = PWR_CSR_EWUP;
+constexpr auto PWR_SW_EXTI = EXTI0;
+constexpr auto PWR_SW_EXTI_IRQ = NVIC_EXTI0_IRQ;
+
+constexpr auto BUTTON_TIMER = TIM2;
+constexpr auto BUTTON_TIMER_RCC = RCC_TIM2;
+constexpr auto BUTTON_TIMER_IRQ = NVIC_TIM2_IRQ;
 
 constexpr auto MBI_LE = GPIO4;
 constexpr auto MBI_DCLK = GPIO5;
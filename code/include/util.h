@@ -1,7 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <random>
-#include <string>
+#include <string_view>
 
 #include "config.h"
 
@@ -11,15 +12,41 @@
             uart_writes(x);                                                                                            \
     } while (0)
 
+#define debug_u32(x)                                                                                                   \
+    do {                                                                                                               \
+        if (DEBUG)                                                                                                     \
+            uart_write_u32(x);                                                                                         \
+    } while (0)
+
+#define debug_hex(x)                                                                                                   \
+    do {                                                                                                               \
+        if (DEBUG)                                                                                                     \
+            uart_write_hex(x);                                                                                         \
+    } while (0)
+
 #define _BV(x) ((1 << x))
 
-void uart_writes(const std::string&);
+void uart_writes(std::string_view);
+void uart_write_u32(uint32_t);
+void uart_write_hex(uint32_t);
+uint32_t uart_dropped();
+bool uart_getc(uint8_t&);
 
 void cpu_sleep();
 void cpu_off();
 
 uint32_t get_true_random_seed();
 
+uint32_t cycle_stamp();
+uint32_t cycles_since(const uint32_t stamp);
+
+// Whether frame counter `now` has got to `target`, even if the frames in between went by unseen (the main loop runs late
+// when an effect overruns). Safe across the counter wrapping, as long as they're less than 2^31 frames apart.
+constexpr bool frame_reached(const uint32_t now, const uint32_t target)
+{
+    return static_cast<int32_t>(now - target) >= 0;
+}
+
 inline uint16_t sat_add(uint16_t a, uint16_t b)
 {
     uint16_t c = a + b;
@@ -44,4 +71,5 @@ inline uint16_t sat_ofs(uint16_t a, int16_t ofs)
         return sat_sub(a, -ofs);
 }
 
-uint32_t get_true_random();
\ No newline at end of file
+uint32_t get_true_random();
+uint16_t get_supply_mv();
\ No newline at end of file
@@ -1,8 +1,8 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <functional>
-#include <string>
 
 #include <libopencm3/stm32/exti.h>
 #include <libopencm3/stm32/gpio.h>
@@ -11,6 +11,7 @@
 #include <libopencm3/stm32/timer.h>
 #include <libopencm3/stm32/usart.h>
 
+#include <libopencm3/cm3/cortex.h>
 #include <libopencm3/cm3/nvic.h>
 
 #include <libopencm3/cm3/systick.h>
@@ -18,45 +19,53 @@
 #include "config.h"
 #include "optimizations.h"
 
+#include "Button.h"
+#include "ClockGovernor.h"
 #include "EffectSetup.h"
 #include "MBI5043.h"
+#include "MainLoop.h"
+#include "PowerModel.h"
+#include "Stream.h"
+#include "SupplyGovernor.h"
 #include "util.h"
 
-#ifdef DEBUG
-#include <cstdio>
-#endif
-
 // MBI5043 LED driver instance
-mbi_t mbi(GPIO_PORT, MBI_LE, MBI_DCLK, MBI_SDI, LED_OUT_MAX);
+mbi_t mbi(GPIO_PORT, MBI_LE, MBI_DCLK, MBI_SDI, MBI_PWR, LED_OUT_MAX);
+
+// Supply current estimate, for battery life projection
+PowerModel power;
+
+// Quality level for the current supply voltage
+SupplyGovernor supply;
 
 // Frame counter
 uint32_t frame = 0;
 
-// Auto power off when we get to this frame
-uint32_t apo_frame = APO_FRAMES;
+// Power/mode button, fed from the EXTI and debounce timer interrupts
+Button button;
+
+// Effects, menus and auto power off
+MainLoop loop(mbi, button);
 
 // Signal between interrupt-driven frame drawing and main loop when it's time to draw the next frame. This variable is
 // stupidly named, when true it represents that a frame has been written to the LEDs and the buffer is ready for the
 // next one
 volatile bool frame_drawn = true;
 
-// Enabled effects
-const std::array<effect_ref, 5> effects = {
-    TwinkleBlinkle,
-    RandomSequence,
-    ChaseRandom,
-    TwinkleTwinkle,
-    ChaseAround,
-};
+// Keyframe rate of the frame waiting in the buffer, as a shift of FPS
+volatile uint8_t keyframe_shift = 0;
 
-uint8_t cur_effect = 0;
-uint8_t cur_bright = 6;
+// Core clock divider for each effect, plus one for menus
+ClockGovernor<effects.size() + 1> clock_gov;
+uint8_t clk_div = 1;
 
-// This is a reference to the MBIEffect instance that will be drawn in the mainloop, it may differ from cur_effect for
-// menus etc.
-auto draw_frame = effects[0];
+// Cycles spent writing the last frame out in the SysTick ISR
+volatile uint32_t output_cycles = 0;
 
-enum menu_state_t { MAIN, BRIGHT };
+// Frames streamed from a host over the UART, and the frame we last got one
+StreamDecoder<mbi_t::N_LEDS> stream_rx;
+uint32_t stream_frame = 0;
+bool streaming = false;
 
 // Set up system clocks
 void clock_setup()
@@ -65,6 +74,34 @@ void clock_setup()
     systick_set_frequency(FPS, F_CPU);
 }
 
+// Run the core at F_CPU / div (1 or 2, see CLK_DIV_MAX). Everything derived from the core clock is adjusted to match:
+// SysTick stays at FPS, the GCLK timer's prescaler makes up the halving so GCLK doesn't change, and the UART keeps its
+// baud rate.
+void clock_set_div(const uint8_t div)
+{
+#ifdef STM32F0
+    static_assert(CLK_DIV_MAX == 2, "Only a halving of the core clock is handled");
+    switch (div) {
+    case 1:
+        rcc_set_hpre(RCC_CFGR_HPRE_NODIV);
+        break;
+    case 2:
+        rcc_set_hpre(RCC_CFGR_HPRE_DIV2);
+        break;
+    default:
+        return;
+    }
+    rcc_ahb_frequency = F_CPU / div;
+    rcc_apb1_frequency = rcc_ahb_frequency;
+
+    systick_set_frequency(FPS, rcc_ahb_frequency);
+    // The GCLK timer divides by 2 by default, which absorbs the halving
+    mbi.set_gclk_prescaler(div == 2 ? 0 : 1);
+    if (DEBUG || ENABLE_STREAM)
+        usart_set_baudrate(USART1, UART_SPEED);
+#endif
+}
+
 // Set up GPIO & alternate functions
 void io_setup()
 {
@@ -77,8 +114,9 @@ void io_setup()
     // Set up GPIO inputs with pull-down
     gpio_mode_setup(GPIO_PORT, GPIO_MODE_INPUT, GPIO_PUPD_PULLDOWN, PWR_SW);
 
-    // Set up USART IOs
-    gpio_mode_setup(GPIO_PORT, GPIO_MODE_AF, GPIO_PUPD_NONE, UART_RX | UART_TX);
+    // Set up USART IOs. RX is pulled up (the idle level) so it doesn't float when nothing's connected.
+    gpio_mode_setup(GPIO_PORT, GPIO_MODE_AF, GPIO_PUPD_NONE, UART_TX);
+    gpio_mode_setup(GPIO_PORT, GPIO_MODE_AF, GPIO_PUPD_PULLUP, UART_RX);
     gpio_set_af(GPIO_PORT, GPIO_AF1, UART_TX | UART_RX);
 
     // Set up GCLK output
@@ -92,7 +130,8 @@ void io_setup()
     gpio_set_mode(GPIO_PORT, GPIO_MODE_INPUT, GPIO_CNF_INPUT_PULL_UPDOWN, PWR_SW);
 
     gpio_set_mode(GPIO_PORT, GPIO_MODE_OUTPUT_10_MHZ, GPIO_CNF_OUTPUT_ALTFN_PUSHPULL, UART_TX);
-    gpio_set_mode(GPIO_PORT, GPIO_MODE_INPUT, GPIO_CNF_INPUT_FLOAT, UART_RX);
+    gpio_set_mode(GPIO_PORT, GPIO_MODE_INPUT, GPIO_CNF_INPUT_PULL_UPDOWN, UART_RX);
+    gpio_set(GPIO_PORT, UART_RX); // pull up
 
     gpio_set_mode(GPIO_PORT, GPIO_MODE_OUTPUT_10_MHZ, GPIO_CNF_OUTPUT_ALTFN_PUSHPULL, MBI_GCLK);
 
@@ -101,10 +140,12 @@ void io_setup()
 #endif
 }
 
-#if DEBUG > 0
-// Set up USART1 to transmit debug messages at 115200bps
+// Set up USART1 at 115200bps to transmit debug messages and receive streamed frames
 void uart_setup()
 {
+    if (!DEBUG && !ENABLE_STREAM)
+        return;
+
     rcc_periph_clock_enable(RCC_USART1);
     usart_set_baudrate(USART1, UART_SPEED);
     usart_set_databits(USART1, 8);
@@ -113,42 +154,104 @@ void uart_setup()
     usart_set_mode(USART1, USART_MODE_TX_RX);
     usart_set_flow_control(USART1, USART_FLOWCONTROL_NONE);
 
+    // Transmit is drained from the TXE interrupt, see uart_writes(). Received bytes are buffered by the same interrupt.
+    if (ENABLE_STREAM)
+        usart_enable_rx_interrupt(USART1);
+    nvic_enable_irq(NVIC_USART1_IRQ);
     usart_enable(USART1);
 }
-#else
-void uart_setup() { }
-#endif
-
-// Set the GPIO that controls the PFET power switch to MBI5043
-// This device has a documented quiescent current of multiple mA, which is way too high when we need a standby current
-// of µA when off.
-void mbi_power(bool on)
-{
-    if (on)
-        gpio_clear(GPIO_PORT, MBI_PWR);
-    else
-        gpio_set(GPIO_PORT, MBI_PWR);
-}
 
 // SysTick ISR
-// When we hit the frame timer, and there's a frame ready for us, draw it and signal back
+// When we hit the frame timer, and the output has caught up with the last keyframe, take the next one if it's ready and
+// signal back. Then write the next interpolated step towards it, if there's anything new to show.
 void sys_tick_handler(void)
 {
-    if (!frame_drawn) {
-        mbi.put_frame<ENABLE_GAMMA>();
+    // A keyframe is due and the main loop is still drawing it
+    bool late = frame_drawn && mbi.keyframe_due();
+    if (!frame_drawn && mbi.keyframe_due()) {
+        mbi.push_keyframe(keyframe_shift);
         frame_drawn = true;
     }
+    loop.deadline.tick(late, keyframe_shift);
+    if (!mbi.keyframe_due()) {
+        auto t = cycle_stamp();
+        if (loop.deadline.skip_gamma())
+            mbi.put_frame<false, ENABLE_DITHER>();
+        else
+            mbi.put_frame<ENABLE_GAMMA, ENABLE_DITHER>();
+        output_cycles = cycles_since(t);
+    }
+    // The LEDs keep showing the last frame whether or not we drew a new one
+    power.update(mbi.output_sum(), mbi.powered());
     // Increment regardless of whether we actually drew a frame to the buffer, this is our timekeeping
     frame++;
 }
 
+// Set up edge interrupts on the button, and a one-shot timer to sample it once it has stopped bouncing
+void button_setup()
+{
+    rcc_periph_clock_enable(BUTTON_TIMER_RCC);
+    timer_set_mode(BUTTON_TIMER, TIM_CR1_CKD_CK_INT, TIM_CR1_CMS_EDGE, TIM_CR1_DIR_UP);
+    timer_one_shot_mode(BUTTON_TIMER);
+    timer_update_on_overflow(BUTTON_TIMER); // so loading the prescaler doesn't fire the interrupt
+    timer_enable_irq(BUTTON_TIMER, TIM_DIER_UIE);
+    nvic_enable_irq(BUTTON_TIMER_IRQ);
+
+#ifdef STM32F0
+    rcc_periph_clock_enable(RCC_SYSCFG_COMP);
+#endif
+    exti_select_source(PWR_SW_EXTI, GPIO_PORT);
+    exti_set_trigger(PWR_SW_EXTI, EXTI_TRIGGER_BOTH);
+    exti_enable_request(PWR_SW_EXTI);
+    nvic_enable_irq(PWR_SW_EXTI_IRQ);
+
+    button.start(gpio_get(GPIO_PORT, PWR_SW));
+}
+
+// Button edge: stop listening to it and sample it again once it has settled
+void button_edge()
+{
+    exti_reset_request(PWR_SW_EXTI);
+    exti_disable_request(PWR_SW_EXTI);
+
+    // 1ms ticks at whatever the core clock currently is
+    timer_set_prescaler(BUTTON_TIMER, rcc_apb1_frequency / 1000 - 1);
+    timer_set_period(BUTTON_TIMER, DEBOUNCE_MS);
+    timer_generate_event(BUTTON_TIMER, TIM_EGR_UG);
+    timer_enable_counter(BUTTON_TIMER);
+}
+
+// Debounce timer expired, the button has settled
+void button_settled()
+{
+    timer_clear_flag(BUTTON_TIMER, TIM_SR_UIF);
+
+    bool sw = gpio_get(GPIO_PORT, PWR_SW);
+    button.edge(sw, frame);
+
+    exti_reset_request(PWR_SW_EXTI);
+    exti_enable_request(PWR_SW_EXTI);
+    // If it changed again while we weren't listening, go around again
+    if (static_cast<bool>(gpio_get(GPIO_PORT, PWR_SW)) != sw)
+        button_edge();
+}
+
+#ifdef STM32F0
+void exti0_1_isr(void) { button_edge(); }
+void tim16_isr(void) { button_settled(); }
+#elif STM32F1
+void exti0_isr(void) { button_edge(); }
+void tim2_isr(void) { button_settled(); }
+#endif
+
 void board_init()
 {
     clock_setup();
     io_setup();
     uart_setup();
+    button_setup();
 
-    mbi_power(true);
+    mbi.power(true);
 
     nvic_enable_irq(NVIC_SYSTICK_IRQ);
     systick_clear();
@@ -156,139 +259,174 @@ void board_init()
     systick_counter_enable();
 }
 
-void set_effect(const uint8_t i)
+// Run at the slowest clock that both the current effect and the supply governor are happy with
+void apply_clock(const uint8_t effect_div)
 {
-    cur_effect = i % effects.size();
-    draw_frame = effects[cur_effect];
-    mbi.clear_buffers();
+    auto div = std::max(effect_div, supply.current().clk_div);
+    if (div != clk_div) {
+        clock_set_div(div);
+        clk_div = div;
+    }
 }
 
-menu_state_t press_main()
+// Feed the (amortized) cost of the frame just drawn to the clock governor
+void scale_clock(const uint32_t cycles)
 {
-    set_effect(cur_effect + 1);
-    return MAIN;
+    apply_clock(clock_gov.update(loop.slot(), cycles));
 }
-menu_state_t press_bright()
+
+// Sample the supply voltage and step quality up or down to suit
+void check_supply()
 {
-    cur_bright = cur_bright == 0 ? 6 : cur_bright - 1;
-    mbi.bright = (static_cast<uint32_t>(1) << (cur_bright + 9)) - 1;
+    auto t = cycle_stamp();
+    auto mv = get_supply_mv();
+    [[maybe_unused]] auto cycles = cycles_since(t);
+
+    auto prev_level = supply.level;
+    supply.update(mv);
+    if (supply.level != prev_level) {
+        loop.max_bright = supply.current().max_bright;
+        loop.apply_brightness();
+        apply_clock(clock_gov.div());
+    }
 
-    indicator.n = cur_bright + 1;
-    draw_frame = indicator;
-    return BRIGHT;
+    debug_str("Supply: ");
+    debug_u32(mv);
+    debug_str("mV (");
+    debug_u32(supply.supply_mv());
+    debug_str(" filtered), level ");
+    debug_u32(supply.level);
+    debug_str(", ");
+    debug_u32(cycles);
+    debug_str(" cycles\n");
 }
 
-menu_state_t long_press_main()
+// Take in whatever has been received over the UART. Returns true if a new streamed frame is ready to show. Once the
+// stream stops for STREAM_TIMEOUT_FRAMES, go back to the local effect. A calibration table takes effect straight away,
+// until power off.
+bool poll_stream()
 {
-    indicator.n = cur_bright + 1;
-    draw_frame = indicator;
-    return BRIGHT;
+    bool got = false;
+    uint8_t b;
+    while (uart_getc(b)) {
+        if (stream_rx.feed(b)) {
+            streamed.frame = stream_rx.frame();
+            stream_frame = frame;
+            got = true;
+        }
+    }
+    if (auto cal = stream_rx.take_cal()) {
+        // SysTick's correct_frame() works from the table and may rescale it itself, keep it out until the new one's in
+        cm_disable_interrupts();
+        mbi.set_calibration(cal->data());
+        cm_enable_interrupts();
+        debug_str("Calibration updated\n");
+    }
+
+    if (got && !streaming) {
+        debug_str("Streaming\n");
+        streaming = true;
+    } else if (streaming && frame - stream_frame > STREAM_TIMEOUT_FRAMES) {
+        debug_str("Stream stopped, ");
+        debug_u32(stream_rx.errors);
+        debug_str(" bad packets\n");
+        streaming = false;
+        loop.end_stream();
+    }
+    return got;
 }
-menu_state_t long_press_bright()
+
+#if DEBUG > 0
+// Print the supply current estimate and projected battery life
+void report_power()
 {
-    set_effect(cur_effect);
-    return MAIN;
+    debug_str("Power: avg ");
+    debug_u32(power.average_ua());
+    debug_str("uA, used ");
+    debug_u32(power.used_uah());
+    debug_str("uAh, ~");
+    debug_u32(power.hours_remaining());
+    debug_str("h remaining\nMBI5043 worst case wake from dark: ");
+    debug_u32(mbi.max_wake_cycles);
+    debug_str(" cycles\n");
+    for (auto i = 0U; i < clock_gov.peak.size(); i++) {
+        auto div = clock_gov.chosen[i];
+        debug_str("Effect ");
+        debug_u32(i);
+        debug_str(": peak ");
+        debug_u32(clock_gov.peak[i]);
+        debug_str(" cycles/frame, clock /");
+        debug_u32(div);
+        debug_str(", saves ~");
+        debug_u32(div ? clock_gov.saving_ua(div) : 0);
+        debug_str("uA\n");
+    }
+    debug_str("Late frames: ");
+    debug_u32(loop.deadline.late_ticks);
+    debug_str(", gamma skipped ");
+    debug_u32(loop.deadline.events[DeadlineGovernor::NO_GAMMA]);
+    debug_str("x, rate halved ");
+    debug_u32(loop.deadline.events[DeadlineGovernor::HALF_RATE]);
+    debug_str("x, effect switched ");
+    debug_u32(loop.deadline.events[DeadlineGovernor::SWITCH]);
+    debug_str("x\n");
+    debug_str("UART bytes dropped: ");
+    debug_u32(uart_dropped());
+    debug_str("\n");
 }
+#else
+void report_power() { }
+#endif
 
 // Called after initialization. To 'request' a power off, mainloop returns, and the caller will power off the CPU or
 // whatever
 void mainloop()
 {
-    enum sw_state_t { WAITING, PRESSED, RELEASED, POWER_OFF_DELAY };
-
-    sw_state_t sw_state = RELEASED; // Button will be pressed on power up, so ignore it for a bit
-    menu_state_t menu_state = MAIN;
-    size_t frames_held = 0;
+    uint32_t report_frame = FPS * 60;
+    uint32_t supply_frame = 0;
 
     while (true) {
         if (frame_drawn) {
-            draw_frame(mbi, frame);
+            auto t = cycle_stamp();
+            uint8_t shift = loop.draw(frame, supply.current().keyframe_shift);
+            keyframe_shift = shift;
             frame_drawn = false;
+            // The render cost is spread over the frames until the next keyframe
+            if (CLOCK_SCALING)
+                scale_clock((cycles_since(t) >> shift) + output_cycles);
         }
 
-        // Do button i/o lazily in the main loop.
-        // This breaks badly if processing a frame takes longer than 1 frame, so don't do that
-        bool sw = gpio_get(GPIO_PORT, PWR_SW);
+        if (ENABLE_STREAM && poll_stream())
+            loop.show_stream();
 
-        if (sw)
-            apo_frame = frame + APO_FRAMES;
+        if (frame_reached(frame, supply_frame)) {
+            check_supply();
+            supply_frame = frame + SUPPLY_SAMPLE_FRAMES;
+        }
 
-        if (frame == apo_frame) {
-            // it's possible that we miss this, if frame generation is taking too long but doing >= instead means we
-            // have to handle overflow
-            return;
+        if (DEBUG && frame_reached(frame, report_frame)) {
+            report_power();
+            report_frame = frame + FPS * 60;
         }
 
-        switch (sw_state) {
-        case WAITING:
-            if (sw) {
-                sw_state = PRESSED;
-                frames_held = 1;
-            }
+        bool running = loop.step(frame, streaming);
+        switch (loop.event) {
+        case Button::SHORT:
+            debug_str("Short press detected\n");
             break;
-        case PRESSED:
-            // If the switch is still held, don't act yet, but update the display to show we received the input
-            if (sw) {
-                frames_held++;
-                if (frames_held >= PWR_PRESS) {
-                    // Turn off all the LEDs to indicate we are about to turn off
-                    draw_frame = AllOff;
-                } else if (frames_held > LONG_PRESS) {
-                    // Turn on one LED to indicate we received the long-press
-                    indicator.n = 1;
-                    draw_frame = indicator;
-                }
-            } else {
-                if (frames_held <= LONG_PRESS) {
-                    debug_str("Short press detected\n");
-                    switch (menu_state) {
-                    case MAIN:
-                        menu_state = press_main();
-                        break;
-                    case BRIGHT:
-                        menu_state = press_bright();
-                        break;
-                    }
-                } else if (frames_held >= PWR_PRESS) {
-                    // I would rather this happened immediately when the button has been held for a few
-                    // seconds, but this causes the processor to be unable to wake up
-                    debug_str("Waiting to standby\n");
-                    sw_state = POWER_OFF_DELAY;
-
-                    break;
-                } else {
-                    debug_str("Long press detected\n");
-                    switch (menu_state) {
-                    case MAIN:
-                        menu_state = long_press_main();
-                        break;
-                    case BRIGHT:
-                        menu_state = long_press_bright();
-                        break;
-                    }
-                }
-                sw_state = RELEASED;
-                frames_held = 0;
-            }
+        case Button::LONG:
+            debug_str("Long press detected\n");
             break;
-        case RELEASED:
-            frames_held++;
-            // DEBOUNCE_DELAY dead frames before we accept button presses again
-            if (frames_held >= DEBOUNCE_DELAY) {
-                sw_state = WAITING;
-                frames_held = 0;
-            }
+        case Button::POWER:
+            debug_str("Waiting to standby\n");
             break;
-
-        case POWER_OFF_DELAY:
-            frames_held++;
-            // Wait DEBOUNCE_DELAY frames after PWR_SW released to make sure it has settled before powering off
-            if (frames_held >= DEBOUNCE_DELAY) {
-                debug_str("Mainloop returning to enter standby\n");
-                return;
-            }
+        case Button::NONE:
             break;
         }
+        if (!running) {
+            debug_str("Mainloop returning to enter standby\n");
+            return;
+        }
 
         // Sleep until the next frame interrupt
         cpu_sleep();
@@ -301,33 +439,37 @@ int main(void)
     board_init();
     debug_str("board inited\n");
 
-#if DEBUG > 0
-    char buf[128];
-    snprintf(buf, 128, "\n\nGamma approximation coefficients (float32):\n");
-    debug_str(buf);
+    debug_str("\n\nGamma approximation coefficients (float32):\n");
     for (auto i = 0U; i < mbi.gamma_coeffs.size(); i++) {
-        const unsigned char* c = (const unsigned char*)(&mbi.gamma_coeffs[i]);
-        snprintf(buf, 128, "\t%i: 0x%02x%02x%02x%02x\n", i, *c, *(c + 1), *(c + 2), *(c + 3));
-        debug_str(buf);
+        uint32_t bits;
+        std::memcpy(&bits, &mbi.gamma_coeffs[i], sizeof(bits));
+        debug_str("\t");
+        debug_u32(i);
+        debug_str(": 0x");
+        debug_hex(bits);
+        debug_str("\n");
     }
-#endif
     mbi.config = (mbi.config
                      & ~(_BV(mbi_t::GAIN_B0) | _BV(mbi_t::GAIN_B1) | _BV(mbi_t::GAIN_B2) | _BV(mbi_t::GAIN_B3)
                          | _BV(mbi_t::GAIN_B4) | _BV(mbi_t::GAIN_B5)))
         | (MBI_GAIN << 4); // set only the gain bits to the configured current gain
     mbi.config |= _BV(mbi_t::GCLK_DDR); // and enable clock doubling mode
-    mbi_power(true);
+    mbi.output_limit = PowerModel::max_out_sum(CURRENT_LIMIT_UA);
+    mbi.dark_gate_frames = MBI_DARK_FRAMES;
+    mbi.dark_power_off = MBI_DARK_POWER_OFF;
+    mbi.power_up_cycles = MBI_POWER_UP_US * (F_CPU / 1000000);
+    mbi.power(true);
     mbi.start();
     debug_str("MBI5043 started\n");
 
     effect_rng.seed(get_true_random);
 
-    set_effect(std::uniform_int_distribution<uint8_t>(0, effects.size() - 1)(effect_rng));
+    loop.set_effect(std::uniform_int_distribution<uint8_t>(0, effects.size() - 1)(effect_rng));
 
     mainloop();
 
     mbi.stop();
-    mbi_power(false);
+    mbi.power(false);
     cpu_off(); // This will not return, since the device's registers and SRAM are reset after wakeup from deep sleep
     debug_str("Here be dragons\n");
 }
@@ -7,19 +7,110 @@
 #include <libopencm3/stm32/rcc.h>
 #include <libopencm3/stm32/usart.h>
 
+#include "RingBuffer.h"
 #include "config.h"
 #include "util.h"
 
-// Write a string to USART1
-void uart_writes(const std::string& str)
+#if DEBUG
+// Bytes waiting to go out of USART1, drained by its interrupt. Writers never block or allocate: anything that doesn't
+// fit is dropped and counted. Only debug output is sent, so release builds don't spend the RAM on it.
+static RingBuffer<char, 256> uart_tx;
+static uint32_t uart_tx_dropped = 0;
+
+static void uart_putc(const char c)
+{
+    if (!uart_tx.push(c))
+        uart_tx_dropped++;
+}
+#endif
+
+// Bytes received on USART1, filled by its interrupt and drained by the main loop. A frame and a half of streaming.
+// Only referenced with ENABLE_STREAM.
+static RingBuffer<uint8_t, 64> uart_rx;
+
+#ifdef STM32F0
+constexpr auto UART_FLAG_TXE = USART_ISR_TXE;
+constexpr auto UART_FLAG_RXNE = USART_ISR_RXNE;
+#else
+constexpr auto UART_FLAG_TXE = USART_SR_TXE;
+constexpr auto UART_FLAG_RXNE = USART_SR_RXNE;
+#endif
+
+#if DEBUG
+// Start the interrupt draining the buffer (if it isn't already)
+static void uart_kick() { usart_enable_tx_interrupt(USART1); }
+#endif
+
+void usart1_isr(void)
+{
+    if (ENABLE_STREAM && usart_get_flag(USART1, UART_FLAG_RXNE)) {
+        // Reading clears RXNE. If the main loop doesn't keep up the byte is lost, the stream decoder will notice.
+        uart_rx.push(usart_recv(USART1));
+    }
+#ifdef STM32F0
+    // An overrun (we were too slow to take the previous byte) holds the interrupt until cleared. On F1 the read above
+    // clears it.
+    if (usart_get_flag(USART1, USART_ISR_ORE))
+        USART_ICR(USART1) = USART_ICR_ORECF;
+#endif
+#if DEBUG
+    char c;
+    if (usart_get_flag(USART1, UART_FLAG_TXE)) {
+        if (uart_tx.pop(c))
+            usart_send(USART1, c);
+        else
+            usart_disable_tx_interrupt(USART1);
+    }
+#endif
+}
+
+// Take the next received byte, false if there isn't one
+bool uart_getc(uint8_t& b) { return ENABLE_STREAM && uart_rx.pop(b); }
+
+#if DEBUG
+// Queue a string for USART1
+void uart_writes(std::string_view str)
 {
     for (auto c : str) {
         if (c == '\n')
-            usart_send_blocking(USART1, '\r');
-        usart_send_blocking(USART1, c);
+            uart_putc('\r');
+        uart_putc(c);
     }
+    uart_kick();
+}
+
+// Queue an unsigned integer in decimal
+void uart_write_u32(uint32_t val)
+{
+    char digits[10];
+    auto n = 0U;
+    do {
+        digits[n++] = '0' + val % 10;
+        val /= 10;
+    } while (val);
+    while (n)
+        uart_putc(digits[--n]);
+    uart_kick();
+}
+
+// Queue a 32-bit value as 8 hex digits
+void uart_write_hex(const uint32_t val)
+{
+    for (int shift = 28; shift >= 0; shift -= 4)
+        uart_putc("0123456789abcdef"[(val >> shift) & 0xf]);
+    uart_kick();
 }
 
+// Number of bytes dropped because the TX buffer was full
+uint32_t uart_dropped() { return uart_tx_dropped; }
+#else
+// Nothing is sent without DEBUG (the debug_ macros don't call these), but keep them linkable
+void uart_writes(std::string_view) { }
+void uart_write_u32(uint32_t) { }
+void uart_write_hex(uint32_t) { }
+uint32_t uart_dropped() { return 0; }
+#endif
+
 // For some reason libopencm3 doesn't seem to provide this. Call the 'wait for
 // interrupt' operation to put the cpu to sleep.
 void cpu_sleep() { asm("wfi"); }
@@ -40,19 +131,21 @@ void cpu_off()
     asm("wfi");
 }
 
-// Use the ADC to get a non-deterministic value, that will be used to seed the RNG so we can have a random effect at
-// startup. Collects ADC values, uses von Neumann de-biasing on the bottom 2 (noisiest) bits to generate a 32-bit value.
-// Probably not good enough for crypto, but certainly good enough to randomly choose 1 of 5 effects.
-uint32_t get_true_random()
+// SysTick counts down from its reload value at the core clock, so it doubles as a cycle counter for anything shorter
+// than a frame (the M0 has no DWT cycle counter). Includes any interrupts that fired in between.
+uint32_t cycle_stamp() { return systick_get_value(); }
+
+uint32_t cycles_since(const uint32_t stamp)
 {
-    using result_t = uint32_t;
-    result_t ret = 0;
-    uint8_t bits_left = sizeof(result_t) * 8;
+    uint32_t now = systick_get_value();
+    return now <= stamp ? stamp - now : stamp + systick_get_reload() + 1 - now;
+}
 
+// Power up the ADC for single conversions of one channel
+static void adc_start(uint8_t channel, uint8_t sample_time)
+{
     rcc_periph_clock_enable(RCC_ADC);
 
-    gpio_mode_setup(GPIOA, GPIO_MODE_ANALOG, GPIO_PUPD_NONE, GPIO1);
-
     adc_power_off(ADC);
     adc_set_clk_source(ADC, ADC_CLKSOURCE_ADC);
     adc_calibrate(ADC);
@@ -60,20 +153,45 @@ uint32_t get_true_random()
     adc_set_operation_mode(ADC, ADC_MODE_SCAN);
     adc_disable_external_trigger_regular(ADC);
     adc_set_right_aligned(ADC);
-    adc_set_sample_time_on_all_channels(ADC, ADC_SMPTIME_001DOT5);
-    uint8_t chans[] = { 1, 1, 9 };
-    adc_set_regular_sequence(ADC, 1, chans);
+    adc_set_sample_time_on_all_channels(ADC, sample_time);
+    adc_set_regular_sequence(ADC, 1, &channel);
     adc_set_resolution(ADC, ADC_RESOLUTION_12BIT);
     adc_disable_analog_watchdog(ADC);
 
     adc_power_on(ADC);
+}
+
+static uint16_t adc_convert()
+{
+    adc_start_conversion_regular(ADC);
+    while (!adc_eoc(ADC))
+        ;
+    return adc_read_regular(ADC);
+}
+
+static void adc_stop()
+{
+    adc_power_off(ADC);
+    rcc_periph_clock_disable(RCC_ADC);
+}
+
+// Use the ADC to get a non-deterministic value, that will be used to seed the RNG so we can have a random effect at
+// startup. Collects ADC values, uses von Neumann de-biasing on the bottom 2 (noisiest) bits to generate a 32-bit value.
+// Probably not good enough for crypto, but certainly good enough to randomly choose 1 of 5 effects.
+uint32_t get_true_random()
+{
+    using result_t = uint32_t;
+    result_t ret = 0;
+    uint8_t bits_left = sizeof(result_t) * 8;
+
+    gpio_mode_setup(GPIOA, GPIO_MODE_ANALOG, GPIO_PUPD_NONE, GPIO1);
+
+    // Sample the floating PA1 as fast as possible, for the most noise
+    adc_start(1, ADC_SMPTIME_001DOT5);
 
     // Remove bias
     while (bits_left) {
-        adc_start_conversion_regular(ADC);
-        while (!adc_eoc(ADC))
-            ;
-        auto val = adc_read_regular(ADC) & 0x03; // get only the bottom 2 bits
+        auto val = adc_convert() & 0x03; // get only the bottom 2 bits
         if (val == 1) { // bottom bits are 01, shift a 0 in
             ret = (ret << 1) | 0;
             bits_left--;
@@ -83,7 +201,20 @@ uint32_t get_true_random()
         } // otherwise ignore and hope for better luck next time
     }
 
-    adc_power_off(ADC);
-    rcc_periph_clock_disable(RCC_ADC);
+    adc_stop();
     return ret;
-}
\ No newline at end of file
+}
+
+// Measure the supply voltage in mV by converting the internal reference against it. VREFINT_CAL is the factory
+// measurement of the reference with VDDA at 3.3V. Takes ~100us including ADC power up and calibration.
+uint16_t get_supply_mv()
+{
+    adc_enable_vrefint();
+    // VREFINT needs a long (>4us) sample time
+    adc_start(ADC_CHANNEL_VREF, ADC_SMPTIME_239DOT5);
+    uint32_t raw = adc_convert();
+    adc_stop();
+    adc_disable_vrefint();
+
+    return raw ? 3300 * static_cast<uint32_t>(ST_VREFINT_CAL) / raw : 0;
+}
@@ -0,0 +1,80 @@
+#include <cstdint>
+
+#include <unity.h>
+
+#include "SimMBI.h"
+
+#include "BakedTables.h"
+#include "Effects.h"
+
+using sim_t = SimMBI<NUM_LEDS>;
+using chase_t = Chase<sim_t, decltype(LED_ORDER)::const_iterator>;
+
+// Run the original effect until it reaches the table's first frame, then both must agree for a couple of periods. Fails
+// if the tables are stale (regenerate with tools/bake.cpp).
+void check_matches(MBIEffect<sim_t>& effect, const BakedTable& table, const uint32_t period)
+{
+    TEST_ASSERT_EQUAL(NUM_LEDS, table.n_leds);
+    sim_t orig, baked;
+    Baked<sim_t> player(table);
+
+    uint32_t f = 0;
+    for (; f < 4096 + period; f++) {
+        effect(orig, f);
+        if (f >= 4096 && std::equal(orig.buffer.begin(), orig.buffer.end(), table.first))
+            break;
+    }
+    TEST_ASSERT_LESS_THAN(4096 + period, f);
+
+    player(baked, 0);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(orig.buffer.data(), baked.buffer.data(), NUM_LEDS);
+    for (uint32_t t = 1; t < 2 * period; t++) {
+        effect(orig, ++f);
+        player(baked, t);
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(orig.buffer.data(), baked.buffer.data(), NUM_LEDS);
+    }
+}
+
+void test_chase_around(void)
+{
+    chase_t effect(LED_ORDER.begin(), LED_ORDER.end(), 120, 3);
+    check_matches(effect, baked::ChaseAround, 1680);
+}
+
+void test_chase_back(void)
+{
+    chase_t effect(LED_ORDER.begin(), LED_ORDER.end(), 15, sim_t::N_LEDS, chase_t::DOWN);
+    check_matches(effect, baked::ChaseBack, 210);
+}
+
+void test_fast_chase(void)
+{
+    chase_t effect(LED_ORDER.begin(), LED_ORDER.end(), 5, 1, chase_t::DOWN);
+    check_matches(effect, baked::FastChase, 70);
+}
+
+void test_wrong_size(void)
+{
+    // Baked for 5 LEDs: the runs are too short for 11, so it mustn't be decoded at all
+    static constexpr uint16_t first[] = { 1000, 2000, 3000, 4000, 5000 };
+    static constexpr int16_t palette[] = { 0, 100 };
+    static constexpr uint8_t runs[] = { 10, 0, 0x11, 0x11, 0x01 };
+    constexpr BakedTable table = { 5, first, palette, runs, 1 };
+    Baked<sim_t> player(table);
+    sim_t mbi;
+    for (uint32_t f = 0; f < 30; f++) {
+        player(mbi, f);
+        for (auto v : mbi.buffer)
+            TEST_ASSERT_EQUAL(0, v);
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_chase_around);
+    RUN_TEST(test_chase_back);
+    RUN_TEST(test_fast_chase);
+    RUN_TEST(test_wrong_size);
+    return UNITY_END();
+}
@@ -0,0 +1,111 @@
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include <unity.h>
+
+#include "Button.h"
+
+// A synthetic timeline of debounced (frame, pressed) edges, as the debounce timer would report them
+using timeline_t = std::initializer_list<std::pair<uint32_t, bool>>;
+
+std::vector<Button::event_t> run(Button& b, timeline_t edges)
+{
+    std::vector<Button::event_t> events;
+    for (auto [frame, pressed] : edges) {
+        b.edge(pressed, frame);
+        for (auto e = b.pop(); e != Button::NONE; e = b.pop())
+            events.push_back(e);
+    }
+    return events;
+}
+
+void test_durations(void)
+{
+    Button b;
+    b.start(false);
+
+    auto events = run(b,
+        {
+            { 100, true }, { 100 + LONG_PRESS, false }, // longest short press
+            { 200, true }, { 200 + LONG_PRESS + 1, false }, // shortest long press
+            { 300, true }, { 300 + PWR_PRESS - 1, false }, // longest long press
+            { 600, true }, { 600 + PWR_PRESS, false }, // power
+        });
+
+    TEST_ASSERT_EQUAL(4, events.size());
+    TEST_ASSERT_EQUAL(Button::SHORT, events[0]);
+    TEST_ASSERT_EQUAL(Button::LONG, events[1]);
+    TEST_ASSERT_EQUAL(Button::LONG, events[2]);
+    TEST_ASSERT_EQUAL(Button::POWER, events[3]);
+}
+
+void test_wake_press_ignored(void)
+{
+    Button b;
+    // Held down from power up, then released: that was the wake up, not a press
+    b.start(true);
+    TEST_ASSERT_EQUAL(0, b.held(10));
+    auto events = run(b, { { 5, false }, { 50, true }, { 55, false } });
+    TEST_ASSERT_EQUAL(1, events.size());
+    TEST_ASSERT_EQUAL(Button::SHORT, events[0]);
+}
+
+void test_held(void)
+{
+    Button b;
+    b.start(false);
+    b.edge(true, 1000);
+    TEST_ASSERT_EQUAL(0, b.held(1000));
+    TEST_ASSERT_EQUAL(PWR_PRESS, b.held(1000 + PWR_PRESS));
+    b.edge(false, 1000 + PWR_PRESS);
+    TEST_ASSERT_EQUAL(0, b.held(1000 + PWR_PRESS + 1));
+    TEST_ASSERT_EQUAL(1000 + PWR_PRESS, b.last_activity);
+}
+
+void test_repeats_ignored(void)
+{
+    Button b;
+    b.start(false);
+    // The debounce timer resamples after every edge, so it can report the same level again
+    auto events = run(b, { { 10, true }, { 12, true }, { 14, false }, { 16, false } });
+    TEST_ASSERT_EQUAL(1, events.size());
+    TEST_ASSERT_EQUAL(Button::SHORT, events[0]);
+}
+
+void test_queue(void)
+{
+    Button b;
+    b.start(false);
+    // Main loop too busy to look for a while: events queue up in order, and excess are dropped
+    for (uint32_t i = 0; i < 10; i++) {
+        b.edge(true, i * 1000);
+        b.edge(false, i * 1000 + (i == 0 ? PWR_PRESS : 1));
+    }
+    TEST_ASSERT_EQUAL(Button::POWER, b.pop());
+    TEST_ASSERT_EQUAL(Button::SHORT, b.pop());
+    TEST_ASSERT_EQUAL(Button::SHORT, b.pop());
+    TEST_ASSERT_EQUAL(Button::NONE, b.pop());
+}
+
+void test_frame_wrap(void)
+{
+    Button b;
+    b.start(false);
+    auto events = run(b, { { UINT32_MAX - 5, true }, { LONG_PRESS + 10, false } });
+    TEST_ASSERT_EQUAL(1, events.size());
+    TEST_ASSERT_EQUAL(Button::LONG, events[0]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_durations);
+    RUN_TEST(test_wake_press_ignored);
+    RUN_TEST(test_held);
+    RUN_TEST(test_repeats_ignored);
+    RUN_TEST(test_queue);
+    RUN_TEST(test_frame_wrap);
+    return UNITY_END();
+}
@@ -0,0 +1,106 @@
+#include <array>
+#include <cstdint>
+
+#include <unity.h>
+
+#include "OutputStage.h"
+
+using stage_t = OutputStage<NUM_LEDS>;
+constexpr uint16_t BRIGHT = (1 << 15) - 1;
+
+// Output of a frame of `vals` through the linear (no gamma, no dither) path, calibrated or not
+template <bool calibrated> stage_t::out_t output(stage_t& stage, const stage_t::fb_t& vals)
+{
+    stage.get_buffer() = vals;
+    stage.push_keyframe(0);
+    stage.correct_frame<false, false, calibrated>();
+    return stage.output();
+}
+
+stage_t::fb_t ramp()
+{
+    stage_t::fb_t vals;
+    for (auto i = 0U; i < NUM_LEDS; i++)
+        vals[i] = i * (UINT16_MAX / (NUM_LEDS - 1));
+    return vals;
+}
+
+void test_default_is_uncalibrated(void)
+{
+    // Until LEDs are measured, LED_CAL leaves the output alone (the golden frames check it with gamma and dithering)
+    stage_t stage(BRIGHT);
+    auto cal = output<true>(stage, ramp());
+    auto plain = output<false>(stage, ramp());
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(plain.data(), cal.data(), NUM_LEDS);
+}
+
+void test_gain_and_offset(void)
+{
+    std::array<led_cal_t, NUM_LEDS> cal;
+    cal.fill({ 0xffff, 0 });
+    cal[1] = { 0x7fff, 0 }; // half as bright
+    cal[2] = { 0xffff, 0x1000 }; // starts from 1/16
+    stage_t stage(BRIGHT);
+    stage.set_calibration(cal.data());
+
+    stage_t::fb_t vals;
+    vals.fill(UINT16_MAX);
+    auto full = output<true>(stage, vals);
+    TEST_ASSERT_UINT16_WITHIN(1, BRIGHT, full[0]);
+    TEST_ASSERT_UINT16_WITHIN(1, BRIGHT / 2, full[1]);
+    // The offset doesn't change full scale
+    TEST_ASSERT_UINT16_WITHIN(1, BRIGHT, full[2]);
+
+    vals.fill(1);
+    auto low = output<true>(stage, vals);
+    TEST_ASSERT_EQUAL(0, low[0]);
+    TEST_ASSERT_EQUAL(BRIGHT / 16, low[2]);
+    // Off is still off
+    vals.fill(0);
+    auto off = output<true>(stage, vals);
+    TEST_ASSERT_EQUAL(0, off[2]);
+}
+
+void test_follows_bright(void)
+{
+    std::array<led_cal_t, NUM_LEDS> cal;
+    cal.fill({ 0x7fff, 0 });
+    stage_t stage(BRIGHT);
+    stage.set_calibration(cal.data());
+    stage_t::fb_t vals;
+    vals.fill(UINT16_MAX);
+
+    // Changing bright is picked up on the next frame
+    stage.bright = BRIGHT / 4;
+    auto out = output<true>(stage, vals);
+    TEST_ASSERT_UINT16_WITHIN(1, BRIGHT / 8, out[0]);
+    auto plain = output<false>(stage, vals);
+    TEST_ASSERT_UINT16_WITHIN(1, BRIGHT / 4, plain[0]);
+}
+
+void test_keeps_a_copy(void)
+{
+    // The table passed in can go once it's set, the stream decoder's is overwritten by the next one received
+    std::array<led_cal_t, NUM_LEDS> cal;
+    cal.fill({ 0x7fff, 0 });
+    stage_t stage(BRIGHT);
+    stage.set_calibration(cal.data());
+    cal.fill({ 0xffff, 0 });
+    stage_t::fb_t vals;
+    vals.fill(UINT16_MAX);
+
+    // Including when a change of bright has it work out the scales again
+    stage.bright = BRIGHT / 2;
+    auto out = output<true>(stage, vals);
+    TEST_ASSERT_UINT16_WITHIN(1, BRIGHT / 4, out[0]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_default_is_uncalibrated);
+    RUN_TEST(test_gain_and_offset);
+    RUN_TEST(test_follows_bright);
+    RUN_TEST(test_keeps_a_copy);
+    return UNITY_END();
+}
@@ -0,0 +1,94 @@
+#include <cstdint>
+#include <iostream>
+
+#include <unity.h>
+
+#include "ClockGovernor.h"
+
+using governor_t = ClockGovernor<2>;
+
+// Feed a constant cost until the peak has decayed onto it
+uint8_t settle(governor_t& gov, uint8_t slot, uint32_t cycles)
+{
+    for (auto i = 0; i < 1000; i++)
+        gov.update(slot, cycles);
+    return gov.div();
+}
+
+void test_budget(void)
+{
+    TEST_ASSERT_EQUAL(F_CPU / FPS, governor_t::budget(1));
+    TEST_ASSERT_EQUAL(F_CPU / FPS / 2, governor_t::budget(2));
+    TEST_ASSERT_EQUAL(0, governor_t::saving_ua(1));
+    TEST_ASSERT_GREATER_THAN(0, governor_t::saving_ua(2));
+    // Never slower than GCLK allows
+    TEST_ASSERT(governor_t::DIVS.back() <= CLK_DIV_MAX);
+}
+
+void test_starts_fast(void)
+{
+    governor_t gov;
+    // Nothing is known about the effect yet, so the first cheap frame doesn't drop the clock
+    TEST_ASSERT_EQUAL(1, gov.update(0, 100));
+}
+
+void test_picks_slowest_fitting(void)
+{
+    governor_t gov;
+    // Trivial effect, e.g. AllToValue, goes as slow as GCLK allows
+    TEST_ASSERT_EQUAL(CLK_DIV_MAX, settle(gov, 0, 1000));
+    // About the cost of gamma correction alone, fits at /2
+    TEST_ASSERT_EQUAL(2, settle(gov, 0, governor_t::budget(2) / 2));
+    // Nearly a full frame needs full speed
+    TEST_ASSERT_EQUAL(1, settle(gov, 0, governor_t::budget(1) * 3 / 4));
+
+    for (uint8_t div : governor_t::DIVS)
+        std::cout << "/" << int(div) << ": budget " << governor_t::budget(div) << " cycles, saves ~"
+                  << governor_t::saving_ua(div) << "uA\n";
+}
+
+void test_overrun_speeds_up(void)
+{
+    governor_t gov;
+    TEST_ASSERT_EQUAL(2, settle(gov, 0, 1000));
+    // One expensive frame goes straight back to full speed...
+    TEST_ASSERT_EQUAL(1, gov.update(0, governor_t::budget(2)));
+    // ...and stays there for a while before decaying back down
+    for (auto i = 0; i < 16; i++)
+        TEST_ASSERT_EQUAL(1, gov.update(0, 1000));
+    TEST_ASSERT_EQUAL(2, settle(gov, 0, 1000));
+}
+
+void test_hysteresis(void)
+{
+    governor_t gov;
+    // Just inside the /2 budget with margin, but not with the extra margin needed to slow down to it
+    uint32_t cycles = governor_t::budget(2) * 100 / (100 + CLOCK_MARGIN_PCT + governor_t::SLOWDOWN_MARGIN_PCT / 2);
+    TEST_ASSERT_EQUAL(1, settle(gov, 0, cycles));
+    // Coming from a cheaper frame, it's allowed to stay at /2
+    settle(gov, 0, governor_t::budget(2) / 4);
+    TEST_ASSERT_EQUAL(2, settle(gov, 0, cycles));
+}
+
+void test_per_effect(void)
+{
+    governor_t gov;
+    settle(gov, 0, 1000);
+    settle(gov, 1, governor_t::budget(1) * 3 / 4);
+    TEST_ASSERT_EQUAL(2, gov.chosen[0]);
+    TEST_ASSERT_EQUAL(1, gov.chosen[1]);
+    // Switching back to the cheap effect uses what was learned about it
+    TEST_ASSERT_EQUAL(2, gov.update(0, 1000));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_budget);
+    RUN_TEST(test_starts_fast);
+    RUN_TEST(test_picks_slowest_fitting);
+    RUN_TEST(test_overrun_speeds_up);
+    RUN_TEST(test_hysteresis);
+    RUN_TEST(test_per_effect);
+    return UNITY_END();
+}
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+
+#include <unity.h>
+
+#include "SimMBI.h"
+
+#include "Compositor.h"
+#include "Effects.h"
+
+using sim_t = SimMBI<NUM_LEDS>;
+using comp_t = Compositor<sim_t, 3>;
+
+// Lane values that hit the edge cases, plus random ones
+template <class F> void for_pairs(F f)
+{
+    const uint16_t edges[] = { 0, 1, 0x7fff, 0x8000, 0x8001, 0xfffe, 0xffff };
+    for (auto a : edges)
+        for (auto b : edges)
+            for (auto c : edges)
+                for (auto d : edges)
+                    f(a, b, c, d);
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<uint16_t> dist;
+    for (auto i = 0; i < 100000; i++)
+        f(dist(gen), dist(gen), dist(gen), dist(gen));
+}
+
+// Check a packed kernel against the scalar version on both lanes
+template <class P, class S> void check_kernel(P packed_f, S scalar_f)
+{
+    for_pairs([&](uint16_t a0, uint16_t a1, uint16_t b0, uint16_t b1) {
+        uint32_t r = packed_f(a0 | static_cast<uint32_t>(a1) << 16, b0 | static_cast<uint32_t>(b1) << 16);
+        TEST_ASSERT_EQUAL(scalar_f(a0, b0), r & 0xffff);
+        TEST_ASSERT_EQUAL(scalar_f(a1, b1), r >> 16);
+    });
+}
+
+void test_kernels(void)
+{
+    check_kernel(packed::add_sat<uint16_t>, [](uint16_t a, uint16_t b) { return sat_add(a, b); });
+    check_kernel(packed::sub_sat<uint16_t>, [](uint16_t a, uint16_t b) { return sat_sub(a, b); });
+    check_kernel(packed::max<uint16_t>, [](uint16_t a, uint16_t b) { return std::max(a, b); });
+    check_kernel(packed::mul<uint16_t>, [](uint16_t a, uint16_t b) { return (static_cast<uint32_t>(a) * (b + 1)) >> 16; });
+    for (uint16_t alpha : { 0, 1, 100, 128, 255, 256 })
+        check_kernel([alpha](uint32_t a, uint32_t b) { return packed::lerp<uint16_t>(a, b, alpha); },
+            [alpha](uint16_t a, uint16_t b) { return (a * (256 - alpha) + b * alpha) >> 8; });
+}
+
+void test_mul_identity(void)
+{
+    // Multiplying by full on leaves a layer alone, by off clears it
+    TEST_ASSERT_EQUAL(0x1234abcd, packed::mul<uint16_t>(0x1234abcd, 0xffffffff));
+    TEST_ASSERT_EQUAL(0, packed::mul<uint16_t>(0x1234abcd, 0));
+}
+
+void test_apply_unaligned(void)
+{
+    // Misaligned frames fall back to a lane at a time with the same result
+    struct {
+        uint16_t pad;
+        std::array<uint16_t, 5> a;
+    } s { 0, { 1, 2, 65535, 4, 5 } };
+    alignas(4) std::array<uint16_t, 5> b { 10, 20, 30, 40, 50 };
+    alignas(4) std::array<uint16_t, 5> c = s.a;
+    packed::apply(s.a, b, packed::add_sat<uint16_t>);
+    packed::apply(c, b, packed::add_sat<uint16_t>);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(c.data(), s.a.data(), 5);
+    TEST_ASSERT_EQUAL(65535, c[2]);
+    TEST_ASSERT_EQUAL(55, c[4]);
+}
+
+void test_layers(void)
+{
+    sim_t mbi;
+    comp_t comp;
+    auto ramp = RampAll<sim_t>(1000);
+    auto first = FirstN<sim_t>(2, true);
+    auto off = AllToValue<sim_t, sim_t::LED_MIN>();
+
+    comp.set(0, &ramp);
+    comp.set(1, &first, comp_t::MAX);
+    for (auto f = 1; f <= 5; f++) {
+        comp(mbi, f);
+        // The ramp carries on in its own layer, whatever the overlay does to the output
+        TEST_ASSERT_EQUAL(65535, mbi.buffer[0]);
+        TEST_ASSERT_EQUAL(65535, mbi.buffer[1]);
+        TEST_ASSERT_EQUAL(1000 * f, mbi.buffer[2]);
+    }
+
+    comp.set(1, &off, comp_t::ALPHA, 192);
+    comp(mbi, 6);
+    TEST_ASSERT_EQUAL(6000 / 4, mbi.buffer[2]);
+
+    comp.set(1, &off, comp_t::MULTIPLY);
+    comp.set(2, &first, comp_t::ADD);
+    comp(mbi, 7);
+    TEST_ASSERT_EQUAL(65535, mbi.buffer[0]);
+    TEST_ASSERT_EQUAL(0, mbi.buffer[2]);
+
+    // Drawing goes back to the real buffer afterwards
+    TEST_ASSERT_EQUAL_PTR(&mbi.buffer, &mbi.get_buffer());
+}
+
+void test_seed(void)
+{
+    sim_t mbi;
+    comp_t comp;
+    auto ramp = RampAll<sim_t>(1);
+    mbi.buffer.fill(500);
+    comp.set(0, &ramp);
+    comp.seed(0, mbi.buffer);
+    comp(mbi, 0);
+    TEST_ASSERT_EQUAL(501, mbi.buffer[0]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_kernels);
+    RUN_TEST(test_mul_identity);
+    RUN_TEST(test_apply_unaligned);
+    RUN_TEST(test_layers);
+    RUN_TEST(test_seed);
+    return UNITY_END();
+}
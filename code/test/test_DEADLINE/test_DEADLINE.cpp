@@ -0,0 +1,126 @@
+#include <cstdint>
+
+#include <unity.h>
+
+#include "DeadlineGovernor.h"
+
+// Late for `ticks` ticks in a row at keyframe shift `key_shift`, then one main loop pass at `frame`
+bool fall_behind(DeadlineGovernor& gov, const uint32_t frame, const uint8_t ticks, const uint8_t key_shift = 0,
+    const bool can_switch = true)
+{
+    for (auto i = 0; i < ticks; i++)
+        gov.tick(true, key_shift);
+    return gov.update(frame, can_switch);
+}
+
+void test_frame_reached(void)
+{
+    TEST_ASSERT_TRUE(frame_reached(100, 100));
+    TEST_ASSERT_TRUE(frame_reached(101, 100));
+    TEST_ASSERT_FALSE(frame_reached(99, 100));
+    // Across the counter wrapping
+    TEST_ASSERT_TRUE(frame_reached(5, UINT32_MAX - 5));
+    TEST_ASSERT_FALSE(frame_reached(UINT32_MAX - 5, 5));
+}
+
+void test_no_gamma(void)
+{
+    DeadlineGovernor gov;
+    TEST_ASSERT_FALSE(gov.skip_gamma());
+    gov.tick(false, 2);
+    TEST_ASSERT_FALSE(gov.skip_gamma());
+
+    // A late tick skips the gamma curve until the next keyframe is due, 4 frames at shift 2
+    gov.tick(true, 2);
+    for (auto i = 0; i < 4; i++)
+        TEST_ASSERT_TRUE(gov.skip_gamma());
+    TEST_ASSERT_FALSE(gov.skip_gamma());
+    TEST_ASSERT_EQUAL(1, gov.late_ticks);
+
+    // Counted once per time it falls behind, not per tick
+    gov.tick(true, 0);
+    gov.tick(true, 0);
+    TEST_ASSERT_EQUAL(2, gov.events[DeadlineGovernor::NO_GAMMA]);
+    TEST_ASSERT_EQUAL(3, gov.late_ticks);
+}
+
+void test_escalates(void)
+{
+    DeadlineGovernor gov;
+    // The odd late frame is tolerated
+    TEST_ASSERT_FALSE(fall_behind(gov, 10, DEADLINE_LATE_LIMIT - 1));
+    TEST_ASSERT_EQUAL(0, gov.shift);
+    // and forgotten after a while
+    TEST_ASSERT_FALSE(gov.update(10 + DEADLINE_WINDOW_FRAMES));
+    TEST_ASSERT_FALSE(fall_behind(gov, 20 + DEADLINE_WINDOW_FRAMES, 1));
+    TEST_ASSERT_EQUAL(0, gov.shift);
+
+    // Persistent lateness halves the rate, up to the limit, then asks for another effect
+    uint32_t frame = 1000;
+    for (auto i = 0; i < DEADLINE_MAX_SHIFT; i++)
+        TEST_ASSERT_FALSE(fall_behind(gov, frame++, DEADLINE_LATE_LIMIT));
+    TEST_ASSERT_EQUAL(DEADLINE_MAX_SHIFT, gov.shift);
+    TEST_ASSERT_EQUAL(DEADLINE_MAX_SHIFT, gov.events[DeadlineGovernor::HALF_RATE]);
+    // A switch the menus hold off isn't one
+    TEST_ASSERT_FALSE(fall_behind(gov, frame++, DEADLINE_LATE_LIMIT, 0, false));
+    TEST_ASSERT_EQUAL(0, gov.events[DeadlineGovernor::SWITCH]);
+    TEST_ASSERT_TRUE(fall_behind(gov, frame, DEADLINE_LATE_LIMIT));
+    TEST_ASSERT_EQUAL(1, gov.events[DeadlineGovernor::SWITCH]);
+
+    // The next effect starts at its own rate, without the previous one's lateness
+    gov.tick(true, 0);
+    gov.reset();
+    TEST_ASSERT_EQUAL(0, gov.shift);
+    TEST_ASSERT_FALSE(fall_behind(gov, frame, DEADLINE_LATE_LIMIT - 1));
+    TEST_ASSERT_EQUAL(0, gov.shift);
+}
+
+void test_reset_window(void)
+{
+    // The previous effect's last pass, just before its window ran out
+    DeadlineGovernor gov;
+    gov.update(0);
+    gov.update(DEADLINE_WINDOW_FRAMES - 1);
+    gov.reset();
+    // The new effect's window starts at the reset, so its lateness isn't thrown away with the old window
+    TEST_ASSERT_FALSE(fall_behind(gov, DEADLINE_WINDOW_FRAMES, DEADLINE_LATE_LIMIT - 1));
+    TEST_ASSERT_FALSE(fall_behind(gov, DEADLINE_WINDOW_FRAMES + 1, 1));
+    TEST_ASSERT_EQUAL(1, gov.shift);
+}
+
+void test_recovers(void)
+{
+    DeadlineGovernor gov;
+    fall_behind(gov, 0, DEADLINE_LATE_LIMIT);
+    fall_behind(gov, 1, DEADLINE_LATE_LIMIT);
+    TEST_ASSERT_EQUAL(2, gov.shift);
+
+    // A step back up for each stretch on time
+    TEST_ASSERT_FALSE(gov.update(DEADLINE_RECOVER_FRAMES));
+    TEST_ASSERT_EQUAL(2, gov.shift);
+    gov.update(1 + DEADLINE_RECOVER_FRAMES);
+    TEST_ASSERT_EQUAL(1, gov.shift);
+    gov.update(DEADLINE_RECOVER_FRAMES * 2);
+    TEST_ASSERT_EQUAL(1, gov.shift);
+    gov.update(1 + DEADLINE_RECOVER_FRAMES * 2);
+    TEST_ASSERT_EQUAL(0, gov.shift);
+
+    // and lateness restarts the wait
+    fall_behind(gov, 10 * DEADLINE_RECOVER_FRAMES, DEADLINE_LATE_LIMIT);
+    TEST_ASSERT_EQUAL(1, gov.shift);
+    gov.tick(true, 0);
+    gov.update(11 * DEADLINE_RECOVER_FRAMES - 1);
+    gov.update(11 * DEADLINE_RECOVER_FRAMES);
+    TEST_ASSERT_EQUAL(1, gov.shift);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_frame_reached);
+    RUN_TEST(test_no_gamma);
+    RUN_TEST(test_escalates);
+    RUN_TEST(test_reset_window);
+    RUN_TEST(test_recovers);
+    return UNITY_END();
+}
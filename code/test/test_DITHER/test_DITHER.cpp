@@ -0,0 +1,85 @@
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+#include <unity.h>
+
+#include "Dither.h"
+
+// Lowest brightness setting in main.cpp, where the corrected output has the fewest codes to work with
+constexpr uint16_t BRIGHT = (1 << 9) - 1;
+constexpr double GAMMA = 2.8;
+constexpr uint8_t FRAC_BITS = 8;
+
+// Slow ramp from off to 1/4 input over this many frames, ~1 minute at 60fps
+constexpr uint32_t RAMP_FRAMES = 4096;
+// Average the output over this many frames when comparing to the exact value, roughly what the eye integrates
+constexpr uint32_t WINDOW = 16;
+
+double exact_output(uint32_t frame)
+{
+    uint16_t val = frame * (UINT16_MAX / 4) / RAMP_FRAMES;
+    return std::pow(val / double(UINT16_MAX), GAMMA) * BRIGHT;
+}
+
+// Mean absolute error of the windowed average output vs. the exact corrected value over the ramp
+template <class Quantizer> double ramp_error(Quantizer q)
+{
+    double total = 0, win_out = 0, win_exact = 0;
+    for (uint32_t frame = 0; frame < RAMP_FRAMES; frame++) {
+        double exact = exact_output(frame);
+        win_out += q(static_cast<uint32_t>(exact * (1 << FRAC_BITS)));
+        win_exact += exact;
+        if ((frame + 1) % WINDOW == 0) {
+            total += std::fabs(win_out - win_exact) / WINDOW;
+            win_out = win_exact = 0;
+        }
+    }
+    return total / (RAMP_FRAMES / WINDOW);
+}
+
+void test_ramp_error(void)
+{
+    SigmaDelta<1, FRAC_BITS> sd;
+
+    double truncated = ramp_error([](uint32_t fine) -> uint16_t { return fine >> FRAC_BITS; });
+    double dithered = ramp_error([&sd](uint32_t fine) -> uint16_t { return sd(0, fine); });
+
+    std::cout << "Mean output error over slow ramp (codes): truncated " << truncated << ", dithered " << dithered
+              << "\n";
+
+    // Truncation is biased by ~half a code, dithering should track to within the window's resolution
+    TEST_ASSERT_GREATER_THAN(0.25, truncated);
+    TEST_ASSERT_LESS_THAN(1.0 / WINDOW, dithered);
+}
+
+void test_off_is_off(void)
+{
+    SigmaDelta<2, FRAC_BITS> sd;
+
+    // Leave some error in the accumulator for LED 0
+    sd(0, (1 << FRAC_BITS) - 1);
+    TEST_ASSERT_EQUAL(0, sd(0, 0));
+    // and it must not carry over once the LED comes back on
+    TEST_ASSERT_EQUAL(0, sd(0, 1));
+    // LEDs don't share error
+    TEST_ASSERT_EQUAL(0, sd(1, (1 << FRAC_BITS) / 2));
+    TEST_ASSERT_EQUAL(1, sd(1, (1 << FRAC_BITS) / 2));
+}
+
+void test_saturates(void)
+{
+    SigmaDelta<1, FRAC_BITS> sd;
+
+    for (auto i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL(UINT16_MAX, sd(0, (uint32_t(UINT16_MAX) << FRAC_BITS) | 0xff));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_ramp_error);
+    RUN_TEST(test_off_is_off);
+    RUN_TEST(test_saturates);
+    return UNITY_END();
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <unity.h>
+
+#include "SimMBI.h"
+
+#include "Baked.h"
+#include "BakedTables.h"
+#include "Compositor.h"
+#include "Effects.h"
+#include "Expand.h"
+
+using sim8_t = SimMBI<NUM_LEDS, uint8_t>;
+using chase8_t = Chase<sim8_t, decltype(LED_ORDER)::const_iterator>;
+
+void test_table_gamma(void)
+{
+    constexpr auto t = expand::table<true>();
+    TEST_ASSERT_EQUAL(0, t[0]);
+    TEST_ASSERT_EQUAL(UINT16_MAX, t[255]);
+    for (auto i = 1U; i < t.size(); i++) {
+        TEST_ASSERT(t[i] >= t[i - 1]);
+        TEST_ASSERT_UINT_WITHIN(1, std::lround(std::pow(i / 255.0, GAMMA) * UINT16_MAX), t[i]);
+    }
+}
+
+void test_table_linear(void)
+{
+    constexpr auto t = expand::table<false>();
+    for (auto i = 0U; i < t.size(); i++)
+        TEST_ASSERT_EQUAL(i << 8 | i, t[i]);
+}
+
+void test_chase8(void)
+{
+    // A chase slower than 8 bits can step still moves, a step of 1 a frame
+    sim8_t mbi;
+    effect_rng = pcg();
+    auto chase = chase8_t(LED_ORDER.begin(), LED_ORDER.end(), 120, 3);
+    for (uint32_t f = 0; f < 1000; f++) {
+        chase(mbi, f);
+        TEST_ASSERT(*std::max_element(mbi.buffer.begin(), mbi.buffer.end()) > 0 || f == 0);
+    }
+}
+
+void test_random_chase8(void)
+{
+    // The default floor is a quarter of full scale at any depth
+    sim8_t mbi;
+    effect_rng = pcg();
+    auto chase = RandomChase<sim8_t>(20, sim8_t::N_LEDS);
+    for (uint32_t f = 0; f < 5000; f++)
+        chase(mbi, f);
+    for (auto v : mbi.buffer)
+        TEST_ASSERT(v >= 64);
+}
+
+void test_twinkle8(void)
+{
+    sim8_t mbi;
+    effect_rng = pcg();
+    auto twinkle = Twinkle<sim8_t>(sim8_t::LED_MAX / 4, 20, 1);
+    for (uint32_t f = 0; f < 5000; f++) {
+        twinkle(mbi, f);
+        // Once every LED has reached its first target, starting from off
+        if (f < 20)
+            continue;
+        for (auto v : mbi.buffer)
+            TEST_ASSERT(v >= sim8_t::LED_MAX / 10 && v <= sim8_t::LED_MAX / 2 + sim8_t::LED_MAX / 4);
+    }
+}
+
+void test_baked8(void)
+{
+    // 16-bit tables play back as their top 8 bits
+    SimMBI<NUM_LEDS> mbi16;
+    sim8_t mbi8;
+    auto b16 = Baked<SimMBI<NUM_LEDS>>(baked::ChaseAround);
+    auto b8 = Baked<sim8_t>(baked::ChaseAround);
+    for (uint32_t f = 0; f < 1000; f++) {
+        b16(mbi16, f);
+        b8(mbi8, f);
+        for (auto i = 0U; i < NUM_LEDS; i++)
+            TEST_ASSERT_EQUAL(mbi16.buffer[i] >> 8, mbi8.buffer[i]);
+    }
+}
+
+void test_compositor8(void)
+{
+    sim8_t mbi;
+    Compositor<sim8_t, 2> comp;
+    auto on = AllToValue<sim8_t, 200>();
+    auto first = FirstN<sim8_t>(2, true);
+    comp.set(0, &on);
+    comp.set(1, &first, Compositor<sim8_t, 2>::ALPHA, 128);
+    comp(mbi, 0);
+    // Halfway from 200 to full on for the first two, and from 200 to off for the rest
+    TEST_ASSERT_EQUAL(227, mbi.buffer[0]);
+    TEST_ASSERT_EQUAL(227, mbi.buffer[1]);
+    TEST_ASSERT_EQUAL(100, mbi.buffer[2]);
+    TEST_ASSERT_EQUAL(100, mbi.buffer[NUM_LEDS - 1]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_table_gamma);
+    RUN_TEST(test_table_linear);
+    RUN_TEST(test_chase8);
+    RUN_TEST(test_random_chase8);
+    RUN_TEST(test_twinkle8);
+    RUN_TEST(test_baked8);
+    RUN_TEST(test_compositor8);
+    return UNITY_END();
+}
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <unity.h>
+
+#include "SimMBI.h"
+
+#include "Fixed.h"
+#include "Waveforms.h"
+
+using fixed::q15;
+using fixed::q16;
+using sim_t = SimMBI<NUM_LEDS>;
+
+void test_saturation(void)
+{
+    TEST_ASSERT_EQUAL(INT16_MAX, (q15::from(0.75) + q15::from(0.75)).raw);
+    TEST_ASSERT_EQUAL(INT16_MIN, (q15::from(-0.75) - q15::from(0.75)).raw);
+    TEST_ASSERT_EQUAL(INT16_MAX, (-q15 { INT16_MIN }).raw);
+    TEST_ASSERT_EQUAL(INT16_MAX, (q15 { INT16_MIN } * q15 { INT16_MIN }).raw);
+    TEST_ASSERT_EQUAL(q15::from(0.25).raw, (q15::from(0.5) * q15::from(0.5)).raw);
+
+    TEST_ASSERT_EQUAL(INT32_MAX, (q16::from_int(30000) + q16::from_int(30000)).raw);
+    TEST_ASSERT_EQUAL(INT32_MAX, (q16::from_int(300) * q16::from_int(300)).raw);
+    TEST_ASSERT_EQUAL(INT32_MIN, (q16::from_int(-300) * q16::from_int(300)).raw);
+    TEST_ASSERT_EQUAL(-5, (q16::from(2.5) * q16::from_int(-2)).to_int());
+    TEST_ASSERT_EQUAL(-3, (-q16::from(2.5)).to_int());
+}
+
+void test_sin(void)
+{
+    for (uint32_t a = 0; a < 0x10000; a++) {
+        auto want = std::sin(a * fixed::PI / 0x8000) * q15::ONE;
+        TEST_ASSERT_INT_WITHIN(5, std::lround(want), fixed::sin(a).raw);
+    }
+    TEST_ASSERT_EQUAL(0, fixed::sin(0).raw);
+    TEST_ASSERT_EQUAL(q15::from(1).raw, fixed::sin(0x4000).raw);
+    TEST_ASSERT_EQUAL(-fixed::sin(0x4000).raw, fixed::sin(0xc000).raw);
+    TEST_ASSERT_EQUAL(fixed::sin(0x4000).raw, fixed::cos(0).raw);
+}
+
+void test_exp(void)
+{
+    for (int32_t raw = -16 * q16::ONE; raw < 14 * q16::ONE; raw += 97) {
+        auto x = q16 { raw };
+        double want = std::exp2(raw / 65536.0);
+        double got = fixed::exp2(x).raw / 65536.0;
+        // Relative error, plus the last bit below 1
+        TEST_ASSERT(std::fabs(got - want) < want * 1e-4 + 1.0 / q16::ONE);
+    }
+    TEST_ASSERT_EQUAL(q16::ONE, fixed::exp2(q16::from_int(0)).raw);
+    TEST_ASSERT_EQUAL(INT32_MAX, fixed::exp2(q16::from_int(15)).raw);
+    TEST_ASSERT_EQUAL(0, fixed::exp2(q16::from_int(-17)).raw);
+
+    for (auto x : { -5.0, -1.0, 0.0, 0.5, 1.0, 3.0, 8.0 }) {
+        double want = std::exp(x);
+        double got = fixed::exp(q16::from(x)).raw / 65536.0;
+        TEST_ASSERT(std::fabs(got - want) <= want * 2e-3 + 2.0 / q16::ONE);
+    }
+}
+
+void test_reciprocal(void)
+{
+    for (int32_t raw = 1; raw < INT32_MAX / 2; raw += raw / 64 + 1) {
+        double want = std::min(65536.0 * 65536.0 / raw, static_cast<double>(INT32_MAX));
+        double got = fixed::reciprocal(q16 { raw }).raw;
+        TEST_ASSERT(std::fabs(got - want) < want * 1e-4 + 2);
+    }
+    TEST_ASSERT_EQUAL(INT32_MAX, fixed::reciprocal(q16 { 0 }).raw);
+    TEST_ASSERT_EQUAL(q16::ONE, fixed::reciprocal(q16::from_int(1)).raw);
+
+    TEST_ASSERT_INT_WITHIN(2, q16::from(2.5).raw, (q16::from_int(10) / q16::from_int(4)).raw);
+    TEST_ASSERT_INT_WITHIN(2, q16::from(-2.5).raw, (q16::from_int(10) / q16::from_int(-4)).raw);
+}
+
+void test_breathe(void)
+{
+    // Once a period, from off to full on, the same on every LED
+    sim_t mbi;
+    auto breathe = Breathe<sim_t>(256);
+    uint16_t lo = UINT16_MAX, hi = 0;
+    for (uint32_t f = 0; f < 256; f++) {
+        breathe(mbi, f);
+        TEST_ASSERT(std::all_of(mbi.buffer.begin(), mbi.buffer.end(), [&](auto v) { return v == mbi.buffer[0]; }));
+        lo = std::min(lo, mbi.buffer[0]);
+        hi = std::max(hi, mbi.buffer[0]);
+    }
+    TEST_ASSERT_UINT_WITHIN(64, 0, lo);
+    TEST_ASSERT_UINT_WITHIN(64, sim_t::LED_MAX, hi);
+}
+
+void test_plasma(void)
+{
+    sim_t mbi;
+    auto plasma = Plasma<sim_t>(100, -70);
+    plasma(mbi, 0);
+    // Both waves start from 0 at the left/top of the board
+    TEST_ASSERT_UINT_WITHIN(2, 0x8000 + fixed::sin(geometry::X[0] << 8).raw / 2, mbi.buffer[0]);
+    uint16_t lo = UINT16_MAX, hi = 0;
+    for (uint32_t f = 0; f < 7000; f++) {
+        plasma(mbi, f);
+        lo = std::min(lo, *std::min_element(mbi.buffer.begin(), mbi.buffer.end()));
+        hi = std::max(hi, *std::max_element(mbi.buffer.begin(), mbi.buffer.end()));
+    }
+    TEST_ASSERT(lo < sim_t::LED_MAX / 50);
+    TEST_ASSERT(hi > sim_t::LED_MAX - sim_t::LED_MAX / 50);
+}
+
+void test_sine_chase(void)
+{
+    // A single peak travels along the order, one place every period / length frames
+    sim_t mbi;
+    auto chase = SineChase<sim_t, decltype(LED_ORDER)::const_iterator>(LED_ORDER.begin(), LED_ORDER.end(), 1400);
+    for (auto p = 0U; p < LED_ORDER.size(); p++) {
+        // A quarter period in, the place at the start of the order is at the top of the wave
+        chase(mbi, 350 + p * 100);
+        TEST_ASSERT_EQUAL(LED_ORDER[p], std::max_element(mbi.buffer.begin(), mbi.buffer.end()) - mbi.buffer.begin());
+        TEST_ASSERT_UINT_WITHIN(sim_t::LED_MAX / 32, sim_t::LED_MAX, mbi.buffer[LED_ORDER[p]]);
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_saturation);
+    RUN_TEST(test_sin);
+    RUN_TEST(test_exp);
+    RUN_TEST(test_reciprocal);
+    RUN_TEST(test_breathe);
+    RUN_TEST(test_plasma);
+    RUN_TEST(test_sine_chase);
+    return UNITY_END();
+}
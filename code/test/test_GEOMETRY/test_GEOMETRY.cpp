@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cstdint>
+
+#include <unity.h>
+
+#include "SimMBI.h"
+
+#include "Geometry.h"
+#include "Spatial.h"
+
+using sim_t = SimMBI<NUM_LEDS>;
+
+// A plus sign: centre, then up, right, down and left of it
+constexpr std::array<led_pos_t, 5> PLUS = { { { 0, 0 }, { 0, -10 }, { 10, 0 }, { 0, 10 }, { -10, 0 } } };
+
+void test_distances(void)
+{
+    constexpr auto d = geometry::distances(PLUS);
+    const uint8_t expect[] = { 0, 255, 255, 255, 255 };
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expect, d.data(), 5);
+
+    // On the board, the middle of the waist is nearest the centre
+    TEST_ASSERT_EQUAL(255, *std::max_element(geometry::DIST.begin(), geometry::DIST.end()));
+    TEST_ASSERT_EQUAL(9, std::min_element(geometry::DIST.begin(), geometry::DIST.end()) - geometry::DIST.begin());
+}
+
+void test_angles(void)
+{
+    // Clockwise from up
+    constexpr auto a = geometry::angles(PLUS);
+    TEST_ASSERT_EQUAL(0, a[1]);
+    TEST_ASSERT_EQUAL(64, a[2]);
+    TEST_ASSERT_EQUAL(128, a[3]);
+    TEST_ASSERT_EQUAL(192, a[4]);
+}
+
+void test_along(void)
+{
+    constexpr auto x = geometry::along(PLUS, &led_pos_t::x);
+    const uint8_t expect[] = { 128, 128, 255, 128, 0 };
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expect, x.data(), 5);
+
+    // The top LED is at the top of the board
+    TEST_ASSERT_EQUAL(0, geometry::Y[0]);
+    TEST_ASSERT_EQUAL(255, geometry::Y[4]);
+}
+
+void test_neighbours(void)
+{
+    constexpr auto adj = geometry::adjacency<geometry::K_NEAREST>(LED_POS);
+    for (auto i = 0U; i < NUM_LEDS; i++) {
+        TEST_ASSERT_FALSE(adj[i] & 1 << i);
+        for (auto j = 0U; j < NUM_LEDS; j++)
+            TEST_ASSERT_EQUAL(static_cast<bool>(adj[i] & 1 << j), static_cast<bool>(adj[j] & 1 << i));
+
+        // The lists have the same LEDs, padded with the LED itself
+        uint16_t listed = 0;
+        for (auto n : geometry::NEIGHBOURS[i])
+            listed |= 1 << n;
+        TEST_ASSERT_EQUAL(adj[i], listed & ~(1 << i));
+    }
+
+    // Light can get everywhere from anywhere
+    uint16_t reached = 1;
+    for (auto hop = 0U; hop < NUM_LEDS; hop++)
+        for (auto i = 0U; i < NUM_LEDS; i++)
+            if (reached & 1 << i)
+                reached |= adj[i];
+    TEST_ASSERT_EQUAL((1 << NUM_LEDS) - 1, reached);
+}
+
+void test_wave(void)
+{
+    // Each LED runs the same wave, delayed by its place in the field
+    sim_t mbi;
+    auto wave = Wave<sim_t>(geometry::DIST, 256);
+    wave(mbi, 0);
+    auto first = mbi.buffer;
+    wave(mbi, 256);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(first.data(), mbi.buffer.data(), NUM_LEDS);
+
+    for (uint32_t f = 0; f < 256; f++) {
+        wave(mbi, f);
+        for (auto i = 0U; i < NUM_LEDS; i++)
+            TEST_ASSERT_EQUAL(triangle<sim_t>((f - geometry::DIST[i]) << 8), mbi.buffer[i]);
+    }
+    TEST_ASSERT_EQUAL(0, triangle<sim_t>(0));
+    TEST_ASSERT_UINT_WITHIN(2, sim_t::LED_MAX, triangle<sim_t>(0x8000));
+}
+
+void test_starburst(void)
+{
+    // One burst spreads to every LED, then everything fades out
+    sim_t mbi;
+    effect_rng = pcg();
+    auto burst = StarBurst<sim_t>(1000, sim_t::LED_MAX / 8, sim_t::LED_MAX / 64, sim_t::LED_MAX / 16);
+    uint16_t lit = 0;
+    for (uint32_t f = 0; f < 500; f++) {
+        burst(mbi, f);
+        for (auto i = 0U; i < NUM_LEDS; i++)
+            if (mbi.buffer[i])
+                lit |= 1 << i;
+    }
+    TEST_ASSERT_EQUAL((1 << NUM_LEDS) - 1, lit);
+    for (auto v : mbi.buffer)
+        TEST_ASSERT_EQUAL(0, v);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_distances);
+    RUN_TEST(test_angles);
+    RUN_TEST(test_along);
+    RUN_TEST(test_neighbours);
+    RUN_TEST(test_wave);
+    RUN_TEST(test_starburst);
+    return UNITY_END();
+}
@@ -0,0 +1,242 @@
+// Generated by tools/golden.cpp, don't edit. To update after changing what the effects show, from code/:
+//   g++ -std=c++17 -O2 -Iinclude -Ilib/rng tools/golden.cpp lib/rng/rng.cpp -o golden
+//   ./golden > test/test_GOLDEN/golden.h
+
+#pragma once
+
+#include "golden_run.h"
+
+const golden_t GOLDEN[] = {
+    { "AllOff", 0x269a93a5, 0x269a93a5,
+        { {
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+        } } },
+    { "AllOn", 0x384382cd, 0x799182cd,
+        { {
+            { 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767 },
+            { 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767 },
+            { 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767 },
+            { 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767 },
+            { 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767 },
+        } } },
+    { "AllRandom", 0xeac50f11, 0x53f908db,
+        { {
+            { 8762, 2964, 18003, 984, 212, 11641, 4383, 27331, 135, 11014, 11600 },
+            { 9225, 80, 8932, 2433, 8363, 0, 1, 3038, 1452, 7204, 27041 },
+            { 23094, 3623, 6396, 8434, 94, 32716, 1742, 12379, 1188, 386, 20362 },
+            { 20496, 1460, 3176, 3260, 466, 11628, 25998, 5664, 2, 22286, 17329 },
+            { 290, 550, 1782, 7093, 2385, 2, 861, 19252, 1, 113, 22174 },
+        } } },
+    { "ChaseAround", 0x0521cac5, 0xafea2678,
+        { {
+            { 1516, 23530, 0, 0, 0, 0, 0, 0, 0, 466, 6335 },
+            { 0, 0, 0, 43, 3401, 16187, 10526, 0, 0, 0, 0 },
+            { 1516, 0, 10527, 0, 0, 0, 0, 0, 32764, 0, 0 },
+            { 0, 0, 0, 0, 0, 0, 466, 6335, 23530, 1516, 0 },
+            { 0, 0, 0, 10526, 0, 0, 0, 0, 43, 3401, 16187 },
+        } } },
+    { "ChaseBack", 0xc40a2646, 0x758aad4b,
+        { {
+            { 10520, 15030, 6992, 405, 61, 7, 0, 0, 32767, 27500, 20671 },
+            { 30026, 1514, 22773, 5130, 2985, 1515, 604, 138, 16799, 11931, 8083 },
+            { 0, 17, 0, 18640, 13411, 9241, 6015, 3620, 1944, 32767, 25081 },
+            { 1155, 2426, 405, 0, 10520, 27463, 20638, 15030, 10539, 7008, 4345 },
+            { 8066, 11908, 5130, 138, 0, 0, 0, 1514, 30066, 22806, 16799 },
+        } } },
+    { "FastChase", 0xa545b685, 0xfae2680f,
+        { {
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 32767, 0 },
+            { 0, 32767, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 0, 0, 0, 0, 0, 0, 0, 32767, 0, 0, 0 },
+            { 0, 0, 0, 32767, 0, 0, 0, 0, 0, 0, 0 },
+            { 0, 0, 32767, 0, 0, 0, 0, 0, 0, 0, 0 },
+        } } },
+    { "ChaseRandom", 0xa71d9585, 0xc864276a,
+        { {
+            { 662, 17272, 21734, 663, 5375, 26889, 13453, 2296, 1344, 10230, 32767 },
+            { 2296, 674, 5336, 10171, 1344, 26777, 13382, 32767, 3647, 21735, 7505 },
+            { 663, 32767, 673, 26889, 21734, 13453, 10231, 663, 17272, 7554, 663 },
+            { 32767, 13382, 673, 3646, 21636, 662, 17188, 10170, 2296, 26889, 1344 },
+            { 13382, 17272, 10231, 5376, 26889, 7553, 663, 663, 21734, 32767, 662 },
+        } } },
+    { "RandomSequence", 0x0b70d94f, 0xa4d3774b,
+        { {
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 32767, 0 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 32767, 0, 0 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 32767 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 32767 },
+            { 0, 32767, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+        } } },
+    { "RampAllUp", 0xac1a2a55, 0x9a0e6c2d,
+        { {
+            { 17359, 17359, 17359, 17359, 17359, 17359, 17359, 17359, 17359, 17359, 17359 },
+            { 7654, 7654, 7654, 7654, 7654, 7654, 7654, 7654, 7654, 7654, 7654 },
+            { 2391, 2391, 2391, 2391, 2391, 2391, 2391, 2391, 2391, 2391, 2391 },
+            { 284, 284, 284, 284, 284, 284, 284, 284, 284, 284, 284 },
+            { 31529, 31529, 31529, 31529, 31529, 31529, 31529, 31529, 31529, 31529, 31529 },
+        } } },
+    { "BakedChaseAround", 0xeca22ac5, 0xaad6a160,
+        { {
+            { 0, 0, 0, 20378, 3898, 0, 0, 0, 0, 235, 5022 },
+            { 17515, 13733, 0, 0, 0, 0, 0, 0, 0, 2, 2533 },
+            { 0, 0, 0, 0, 1007, 8685, 28829, 88, 0, 0, 0 },
+            { 235, 0, 5022, 0, 0, 0, 0, 0, 20378, 3898, 0 },
+            { 0, 0, 0, 0, 0, 0, 2, 2533, 13733, 17515, 0 },
+        } } },
+    { "BakedChaseBack", 0x4779f3fb, 0xdf50d903,
+        { {
+            { 26967, 13725, 20229, 4184, 2322, 1090, 371, 50, 14722, 10275, 6805 },
+            { 0, 0, 0, 16414, 11622, 7843, 4964, 2867, 15394, 29541, 22368 },
+            { 799, 1848, 225, 1, 32187, 24580, 18256, 13100, 9016, 5845, 3496 },
+            { 6790, 10255, 4184, 50, 12, 0, 0, 13725, 27004, 20259, 14722 },
+            { 22335, 29502, 16414, 2867, 1438, 561, 120, 0, 11643, 7860, 28001 },
+        } } },
+    { "BakedFastChase", 0x27e3079f, 0x2137d436,
+        { {
+            { 0, 0, 0, 0, 0, 0, 0, 339, 17526, 0, 0 },
+            { 0, 0, 0, 339, 17526, 0, 0, 0, 0, 0, 0 },
+            { 0, 0, 339, 0, 0, 0, 0, 0, 17526, 0, 0 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 339, 17526 },
+            { 0, 0, 0, 0, 0, 339, 17526, 0, 0, 0, 0 },
+        } } },
+    { "ScriptBreathe", 0xc91cb91e, 0x4bfe902f,
+        { {
+            { 23797, 23797, 23797, 23797, 23797, 23797, 23797, 23797, 23797, 23797, 23797 },
+            { 632, 632, 632, 632, 632, 632, 632, 632, 632, 632, 632 },
+            { 10987, 10987, 10987, 10987, 10987, 10987, 10987, 10987, 10987, 10987, 10987 },
+            { 3778, 3778, 3778, 3778, 3778, 3778, 3778, 3778, 3778, 3778, 3778 },
+            { 3779, 3779, 3779, 3779, 3779, 3779, 3779, 3779, 3779, 3779, 3779 },
+        } } },
+    { "ScriptComet", 0xe2f8129d, 0x677fd244,
+        { {
+            { 0, 0, 357, 0, 0, 0, 0, 0, 5761, 10533, 0 },
+            { 697, 29, 15657, 0, 0, 0, 0, 0, 1517, 0, 0 },
+            { 32767, 1180, 0, 0, 0, 0, 0, 0, 0, 0, 141 },
+            { 0, 10533, 0, 0, 0, 0, 0, 0, 0, 357, 5761 },
+            { 0, 0, 0, 0, 0, 0, 0, 29, 697, 15657, 1517 },
+        } } },
+    { "ScriptHeartbeat", 0xe6f0484b, 0xc7f71417,
+        { {
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 662, 662, 662, 662, 662, 662, 662, 662, 662, 662, 662 },
+            { 6514, 6514, 6514, 6514, 6514, 6514, 6514, 6514, 6514, 6514, 6514 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 },
+        } } },
+    { "ScriptSparkle", 0x7bc41685, 0xf77947ba,
+        { {
+            { 1, 1, 1, 1, 1, 1, 24730, 6828, 2599, 1, 13965 },
+            { 1, 3052, 1, 1, 20, 1, 1, 1, 15265, 1, 26604 },
+            { 16639, 3553, 1, 1, 1, 55, 1, 1, 1, 28572, 1 },
+            { 1, 1, 1, 1, 1, 108, 9489, 1, 1, 1, 30629 },
+            { 1, 1, 184, 19626, 10504, 1500, 1, 1, 1, 4702, 1 },
+        } } },
+    { "ScriptWipe", 0x9692d95e, 0xf572cb2f,
+        { {
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 32767, 32767, 32767, 0, 0, 0, 0, 2535, 17527, 32767, 32767 },
+            { 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767 },
+            { 17526, 32767, 2535, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767 },
+            { 0, 0, 0, 32767, 17526, 2535, 0, 0, 0, 0, 0 },
+        } } },
+    { "RadialPulse", 0x69e34d7b, 0x37909d81,
+        { {
+            { 9975, 17487, 22914, 26279, 25051, 461, 44, 16, 1956, 8702, 2746 },
+            { 11298, 97, 3680, 758, 633, 3338, 6187, 9585, 30328, 12798, 26396 },
+            { 14, 5438, 368, 2550, 2838, 24081, 16721, 11730, 1236, 0, 770 },
+            { 9464, 18245, 22034, 27266, 26007, 541, 67, 7, 1776, 8235, 2524 },
+            { 11869, 130, 3961, 865, 730, 3087, 5813, 9088, 31411, 13418, 27385 },
+        } } },
+    { "Lighthouse", 0xe2c97d05, 0x16beabc4,
+        { {
+            { 24585, 32394, 14440, 1128, 30, 46, 34, 34, 635, 6199, 18037 },
+            { 370, 33, 1914, 7536, 24066, 16250, 16710, 16710, 21598, 6393, 11 },
+            { 11403, 16768, 5549, 5194, 408, 1471, 1374, 1374, 8, 1530, 30526 },
+            { 2954, 1363, 7103, 2105, 11089, 6541, 6798, 6798, 26032, 15983, 88 },
+            { 3957, 6830, 1267, 13779, 3090, 6056, 5818, 5818, 276, 54, 15082 },
+        } } },
+    { "FallingBands", 0x989e0685, 0x3decfe03,
+        { {
+            { 9645, 4, 81, 25270, 10310, 9209, 5003, 2551, 385, 1956, 5299 },
+            { 11661, 7487, 17096, 3020, 10942, 9, 140, 757, 22243, 30328, 18554 },
+            { 8, 14502, 5993, 565, 20, 11589, 18455, 26272, 3893, 1236, 146 },
+            { 9146, 11, 55, 24332, 9789, 9710, 5344, 2775, 320, 1776, 4960 },
+            { 12245, 7063, 16369, 3269, 11501, 19, 105, 659, 21380, 31411, 19341 },
+        } } },
+    { "Bursts", 0xbcf946fc, 0xc0806f8e,
+        { {
+            { 0, 0, 0, 156, 156, 156, 156, 2382, 156, 156, 156 },
+            { 550, 550, 550, 550, 550, 3955, 3955, 3955, 12234, 3955, 3955 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 7, 0 },
+            { 156, 156, 2382, 0, 0, 0, 0, 0, 0, 0, 156 },
+            { 33, 33, 33, 3955, 3955, 12234, 3955, 3955, 3955, 550, 550 },
+        } } },
+    { "Breathing", 0x76d6c0fa, 0x810e1647,
+        { {
+            { 19969, 19969, 19969, 19969, 19969, 19969, 19969, 19969, 19969, 19969, 19969 },
+            { 22467, 22467, 22467, 22467, 22467, 22467, 22467, 22467, 22467, 22467, 22467 },
+            { 1006, 1006, 1006, 1006, 1006, 1006, 1006, 1006, 1006, 1006, 1006 },
+            { 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9 },
+            { 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16 },
+        } } },
+    { "PlasmaField", 0x07d16ec6, 0xa900eba3,
+        { {
+            { 17, 1681, 4076, 9448, 960, 1914, 2551, 3209, 5797, 4455, 6317 },
+            { 26882, 16905, 4215, 5409, 6265, 17099, 14004, 11860, 882, 3075, 4705 },
+            { 2136, 1387, 3457, 430, 5646, 1309, 1787, 2215, 16164, 12106, 7106 },
+            { 972, 1599, 7060, 21915, 5310, 4692, 4891, 4936, 3382, 1473, 1659 },
+            { 17898, 27457, 6710, 2140, 3064, 6395, 4937, 4154, 355, 2789, 6323 },
+        } } },
+    { "SineChaseAround", 0x8f3855db, 0x3fdd1e73,
+        { {
+            { 0, 0, 0, 17775, 32758, 18729, 2503, 0, 0, 1, 2182 },
+            { 28, 643, 0, 0, 0, 0, 94, 5866, 25519, 30685, 11120 },
+            { 11934, 775, 31155, 0, 0, 0, 0, 0, 24679, 5319, 64 },
+            { 0, 0, 0, 19664, 32702, 16843, 1900, 3, 0, 1, 2841 },
+            { 32, 423, 0, 0, 0, 0, 177, 7091, 27123, 29558, 9547 },
+        } } },
+    { "TwinkleTwinkle", 0x5e37f0ce, 0x42f0f676,
+        { {
+            { 6089, 5352, 4884, 3405, 7603, 2379, 5524, 3362, 3251, 3039, 3477 },
+            { 5254, 5785, 3287, 2809, 3852, 3493, 2539, 4310, 7807, 7284, 4663 },
+            { 5667, 3730, 6346, 2769, 5058, 3105, 4772, 2604, 6081, 5965, 5263 },
+            { 6564, 3353, 6901, 5075, 7913, 4160, 3615, 5286, 4043, 5124, 5318 },
+            { 4779, 4235, 4460, 4278, 4772, 7223, 5268, 4368, 6920, 5659, 4192 },
+        } } },
+    { "TwinkleBlinkle", 0xfb70a0aa, 0x953f392c,
+        { {
+            { 2635, 9636, 10797, 10295, 3433, 9800, 3025, 11925, 7620, 11016, 7837 },
+            { 2451, 7710, 7661, 890, 1962, 2063, 10025, 7909, 3811, 2338, 4317 },
+            { 5375, 1594, 8353, 7809, 1652, 2851, 7667, 2944, 4701, 3807, 2339 },
+            { 4412, 3346, 7077, 8526, 4347, 10023, 1211, 2835, 3020, 3311, 2725 },
+            { 3396, 2443, 4950, 1948, 1100, 825, 4939, 1542, 1748, 3348, 2123 },
+        } } },
+    { "NoiseTwinkleTwinkle", 0xdb83c7d0, 0x9dd47148,
+        { {
+            { 3356, 8022, 2531, 2431, 6025, 3477, 5812, 4142, 4646, 7658, 4242 },
+            { 5216, 7724, 8325, 3729, 4555, 4627, 3964, 4657, 2697, 4255, 6832 },
+            { 5521, 6382, 5787, 3681, 3937, 6308, 4062, 2217, 3540, 8228, 4833 },
+            { 3499, 2367, 5833, 6835, 3482, 5248, 6315, 3937, 3555, 7631, 3388 },
+            { 5214, 2716, 3348, 7947, 2619, 6898, 7445, 4971, 4734, 3629, 8423 },
+        } } },
+    { "NoiseTwinkleBlinkle", 0x47db339f, 0x7b7e1bb2,
+        { {
+            { 5853, 12062, 13363, 2805, 4304, 4434, 3220, 4545, 1293, 3693, 9774 },
+            { 2354, 901, 7022, 9395, 2385, 5636, 8503, 3132, 2497, 11804, 2331 },
+            { 11147, 7772, 4214, 5207, 2659, 10568, 1251, 3609, 6769, 5945, 1101 },
+            { 11130, 11757, 2444, 3922, 3653, 3688, 4973, 1331, 3235, 11036, 1938 },
+            { 9878, 2971, 2033, 10435, 2328, 3811, 10402, 4111, 9987, 1864, 8510 },
+        } } },
+    { "indicator", 0x0aa164bd, 0x98d464bd,
+        { {
+            { 32767, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 32767, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 32767, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 32767, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 32767, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+        } } },
+};
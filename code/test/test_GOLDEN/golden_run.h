@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "EffectSetup.h"
+#include "PowerModel.h"
+
+// Runs the effects instantiated in EffectSetup.h the way the firmware does, for the golden frame test and the tool that
+// records its goldens (tools/golden.cpp). Each effect draws into the output stage the firmware uses (OutputStage, the
+// hardware-free part of MBI5043) on the main loop's schedule, and every frame goes through the same keyframe
+// interpolation, gamma correction, dithering and limiting as the SysTick handler's put_frame.
+
+constexpr uint32_t GOLDEN_FRAMES = 5000;
+// Full output frames are kept every this many frames, to compare with a tolerance
+constexpr uint32_t GOLDEN_CHECK_EVERY = 1000;
+constexpr auto GOLDEN_CHECKS = GOLDEN_FRAMES / GOLDEN_CHECK_EVERY;
+
+// main.cpp's default brightness (cur_bright = 6, see apply_brightness)
+constexpr uint16_t GOLDEN_BRIGHT = (1 << (6 + 9)) - 1;
+
+struct golden_t {
+    const char* name;
+    // FNV-1a over every frame the effect drew, and every output frame
+    uint32_t draw_hash, out_hash;
+    std::array<mbi_t::out_t, GOLDEN_CHECKS> checks;
+};
+
+struct golden_effect_t {
+    const char* name;
+    MBIEffect<mbi_t>& effect;
+};
+
+// Every effect in EffectSetup.h except streamed (shows what the host sends) and overlay (the menus set it up). Adding
+// an effect here means recording the goldens again.
+const golden_effect_t GOLDEN_EFFECTS[] = {
+    { "AllOff", AllOff },
+    { "AllOn", AllOn },
+    { "AllRandom", AllRandom },
+    { "ChaseAround", ChaseAround },
+    { "ChaseBack", ChaseBack },
+    { "FastChase", FastChase },
+    { "ChaseRandom", ChaseRandom },
+    { "RandomSequence", RandomSequence },
+    { "RampAllUp", RampAllUp },
+    { "BakedChaseAround", BakedChaseAround },
+    { "BakedChaseBack", BakedChaseBack },
+    { "BakedFastChase", BakedFastChase },
+    { "ScriptBreathe", ScriptBreathe },
+    { "ScriptComet", ScriptComet },
+    { "ScriptHeartbeat", ScriptHeartbeat },
+    { "ScriptSparkle", ScriptSparkle },
+    { "ScriptWipe", ScriptWipe },
+    { "RadialPulse", RadialPulse },
+    { "Lighthouse", Lighthouse },
+    { "FallingBands", FallingBands },
+    { "Bursts", Bursts },
+    { "Breathing", Breathing },
+    { "PlasmaField", PlasmaField },
+    { "SineChaseAround", SineChaseAround },
+    { "TwinkleTwinkle", TwinkleTwinkle },
+    { "TwinkleBlinkle", TwinkleBlinkle },
+    { "NoiseTwinkleTwinkle", NoiseTwinkleTwinkle },
+    { "NoiseTwinkleBlinkle", NoiseTwinkleBlinkle },
+    { "indicator", indicator },
+};
+
+inline uint32_t fnv(uint32_t h, const uint16_t v) { return (h ^ v) * 16777619; }
+
+// Run one effect from a fixed seed, as set_effect() then the main loop and SysTick would
+inline golden_t golden_run(const golden_effect_t& e)
+{
+    golden_t g { e.name, 2166136261, 2166136261, {} };
+    mbi_t mbi(GOLDEN_BRIGHT);
+    mbi.output_limit = PowerModel::max_out_sum(CURRENT_LIMIT_UA);
+    mbi.clear_buffers();
+    effect_rng = pcg();
+
+    bool frame_drawn = true;
+    uint8_t keyframe_shift = 0;
+    for (uint32_t frame = 0; frame < GOLDEN_FRAMES; frame++) {
+        // mainloop()
+        if (frame_drawn) {
+            keyframe_shift = e.effect.frame_shift = e.effect.keyframe_shift();
+            e.effect(mbi, frame);
+            frame_drawn = false;
+            for (auto v : mbi.cur_frame())
+                g.draw_hash = fnv(g.draw_hash, v);
+        }
+        // sys_tick_handler()
+        if (!frame_drawn && mbi.keyframe_due()) {
+            mbi.push_keyframe(keyframe_shift);
+            frame_drawn = true;
+        }
+        if (!mbi.keyframe_due())
+            mbi.correct_frame<ENABLE_GAMMA, ENABLE_DITHER>();
+        for (auto v : mbi.output())
+            g.out_hash = fnv(g.out_hash, v);
+        if ((frame + 1) % GOLDEN_CHECK_EVERY == 0)
+            g.checks[frame / GOLDEN_CHECK_EVERY] = mbi.output();
+    }
+    return g;
+}
@@ -0,0 +1,48 @@
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+
+#include <unity.h>
+
+#include "golden.h"
+#include "golden_run.h"
+
+// How far an output value may stray from its golden (of 16 bits) before it's a change anyone could see. Lets changes
+// to e.g. the gamma approximation or dithering through, as long as the effects themselves draw exactly the same.
+constexpr int32_t OUT_TOLERANCE = 64;
+
+void test_all_recorded(void)
+{
+    // An effect added without recording its goldens (see tools/golden.cpp)
+    TEST_ASSERT_EQUAL(std::size(GOLDEN_EFFECTS), std::size(GOLDEN));
+    for (auto i = 0U; i < std::size(GOLDEN); i++)
+        TEST_ASSERT_EQUAL_STRING(GOLDEN_EFFECTS[i].name, GOLDEN[i].name);
+}
+
+void test_effects(void)
+{
+    for (auto i = 0U; i < std::size(GOLDEN_EFFECTS) && i < std::size(GOLDEN); i++) {
+        auto& want = GOLDEN[i];
+        auto got = golden_run(GOLDEN_EFFECTS[i]);
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%s drew something different", want.name);
+        TEST_ASSERT_EQUAL_HEX32_MESSAGE(want.draw_hash, got.draw_hash, msg);
+
+        if (got.out_hash == want.out_hash)
+            continue;
+        for (auto c = 0U; c < GOLDEN_CHECKS; c++) {
+            for (auto led = 0U; led < mbi_t::N_LEDS; led++) {
+                snprintf(msg, sizeof(msg), "%s output, frame %u LED %u", want.name, (c + 1) * GOLDEN_CHECK_EVERY, led);
+                TEST_ASSERT_INT_WITHIN_MESSAGE(OUT_TOLERANCE, want.checks[c][led], got.checks[c][led], msg);
+            }
+        }
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_all_recorded);
+    RUN_TEST(test_effects);
+    return UNITY_END();
+}
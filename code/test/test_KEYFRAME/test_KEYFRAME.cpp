@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <unity.h>
+
+#include "SimMBI.h"
+
+#include "Baked.h"
+#include "BakedTables.h"
+#include "Effects.h"
+#include "Script.h"
+#include "Scripts.h"
+#include "Spatial.h"
+
+using sim_t = SimMBI<NUM_LEDS>;
+using frames_t = std::vector<sim_t::fb_t>;
+using chase_t = Chase<sim_t, decltype(LED_ORDER)::const_iterator>;
+
+constexpr uint32_t FRAMES = 2400;
+
+// Draw an effect the way the main loop does at keyframe shift `shift`: a call every 2^shift frames, told the shift
+frames_t run(MBIEffect<sim_t>& effect, const uint8_t shift)
+{
+    sim_t mbi;
+    effect.frame_shift = shift;
+    frames_t out;
+    for (uint32_t f = 0; f < FRAMES; f += 1U << shift) {
+        effect(mbi, f);
+        out.push_back(mbi.buffer);
+    }
+    return out;
+}
+
+// A call at shift 2 covers the frames up to the next call, so it should draw what four calls at shift 0 do. Effects
+// that draw before stepping show the first of them, `first` is set for those.
+template <class F> void check_same_speed(F make, const uint16_t tolerance = 0, const bool first = false)
+{
+    // From the same seed, some effects draw from the RNG as they're made
+    effect_rng = pcg();
+    auto a = make();
+    auto every = run(a, 0);
+    effect_rng = pcg();
+    auto b = make();
+    auto quarter = run(b, 2);
+    for (auto k = 0U; k < quarter.size(); k++)
+        for (auto i = 0U; i < NUM_LEDS; i++)
+            TEST_ASSERT_UINT_WITHIN(tolerance, every[4 * k + (first ? 0 : 3)][i], quarter[k][i]);
+}
+
+// Largest change of any LED between consecutive calls, per frame
+uint32_t max_step(const frames_t& frames, const uint8_t shift)
+{
+    uint32_t step = 0;
+    for (auto k = 1U; k < frames.size(); k++)
+        for (auto i = 0U; i < NUM_LEDS; i++)
+            step = std::max<uint32_t>(step, std::abs(frames[k][i] - frames[k - 1][i]));
+    return step >> shift;
+}
+
+void test_twinkle_fade(void)
+{
+    // Interpolated between keyframes, a fade at shift 1 or 2 changes no faster than one drawn every frame: no jump at
+    // the end when the target frame comes round
+    effect_rng = pcg();
+    Twinkle<sim_t> every((sim_t::LED_MAX + 1) / 8, 40);
+    auto full = max_step(run(every, 0), 0);
+    for (uint8_t shift : { 1, 2 }) {
+        effect_rng = pcg();
+        Twinkle<sim_t> slow((sim_t::LED_MAX + 1) / 8, 40, shift);
+        auto step = max_step(run(slow, shift), shift);
+        TEST_ASSERT_LESS_OR_EQUAL(full * 5 / 4, step);
+    }
+}
+
+void test_chase_speed(void)
+{
+    check_same_speed([] { return chase_t(LED_ORDER.begin(), LED_ORDER.end(), 20, 3); });
+    check_same_speed([] { return RandomChase<sim_t>(20, NUM_LEDS); });
+    check_same_speed([] { return RampAll<sim_t>(sim_t::LED_MAX / 128); });
+}
+
+void test_baked_speed(void)
+{
+    check_same_speed([] { return Baked<sim_t>(baked::ChaseBack); }, 0, true);
+}
+
+void test_script_speed(void)
+{
+    // Ramps are worked out over several frames at once, so they can round differently. Scripts share the VM, which
+    // carries on unless a different script takes over.
+    auto make = [](const auto& code) {
+        return [&code] {
+            Script<sim_t>::vm = ScriptVM<NUM_LEDS>();
+            return Script<sim_t>(code);
+        };
+    };
+    check_same_speed(make(scripts::comet), 8);
+    check_same_speed(make(scripts::heartbeat), 8);
+}
+
+void test_starburst_speed(void)
+{
+    // Bursts come every interval frames whatever the shift
+    auto count = [](const uint8_t shift) {
+        effect_rng = pcg();
+        StarBurst<sim_t> burst(FPS, sim_t::LED_MAX / 8, sim_t::LED_MAX / 64, sim_t::LED_MAX / 4);
+        auto frames = run(burst, shift);
+        uint32_t n = 0;
+        for (auto& fb : frames)
+            n += std::count(fb.begin(), fb.end(), sim_t::LED_MAX);
+        return n;
+    };
+    TEST_ASSERT_EQUAL(FRAMES / FPS, count(0));
+    TEST_ASSERT_EQUAL(FRAMES / FPS, count(2));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_twinkle_fade);
+    RUN_TEST(test_chase_speed);
+    RUN_TEST(test_baked_speed);
+    RUN_TEST(test_script_speed);
+    RUN_TEST(test_starburst_speed);
+    return UNITY_END();
+}
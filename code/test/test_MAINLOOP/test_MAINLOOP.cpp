@@ -0,0 +1,228 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <unity.h>
+
+#include "timewarp.h"
+
+// Run a scenario from power on, failing on any unmet expectation
+void run(const char* scenario, const uint8_t effect = 0)
+{
+    std::vector<timewarp_step_t> steps;
+    auto bad = parse_scenario(scenario, steps);
+    TEST_ASSERT_EQUAL_MESSAGE(0, bad, "Scenario doesn't parse");
+
+    Timewarp tw(effect);
+    for (auto& f : tw.run(steps))
+        TEST_FAIL_MESSAGE(f.c_str());
+}
+
+void test_parse(void)
+{
+    std::vector<timewarp_step_t> steps;
+    TEST_ASSERT_EQUAL(0, parse_scenario("# comment\n\n90 press\n+0.5s release\n2m click\n1h expect off\n", steps));
+    TEST_ASSERT_EQUAL(5, steps.size());
+    TEST_ASSERT_EQUAL(90, steps[0].frame);
+    TEST_ASSERT_EQUAL(90 + FPS / 2, steps[1].frame);
+    TEST_ASSERT_EQUAL(timewarp_step_t::RELEASE, steps[1].action);
+    TEST_ASSERT_EQUAL(FPS * 120, steps[2].frame);
+    TEST_ASSERT_EQUAL(FPS * 120 + CLICK_FRAMES, steps[3].frame);
+    TEST_ASSERT_EQUAL(FPS * 3600, steps[4].frame);
+    TEST_ASSERT_EQUAL(6, steps[4].line);
+
+    steps.clear();
+    TEST_ASSERT_EQUAL(0, parse_scenario("1s stall 0.5s\n", steps));
+    TEST_ASSERT_EQUAL(timewarp_step_t::STALL, steps[0].action);
+    TEST_ASSERT_EQUAL(FPS / 2, steps[0].arg);
+
+    steps.clear();
+    TEST_ASSERT_EQUAL(2, parse_scenario("1 press\n2 jump\n", steps));
+    TEST_ASSERT_EQUAL(1, parse_scenario("1x press\n", steps));
+    TEST_ASSERT_EQUAL(1, parse_scenario("1 expect menu sideways\n", steps));
+}
+
+void test_apo(void)
+{
+    // Four hours of frames, of a cheap effect (BakedChaseAround). tools/timewarp reports how long scenarios take.
+    run("14399s expect on\n"
+        "+2s expect off\n",
+        4);
+
+    // Any press puts it off
+    run("3h click\n"
+        "+14399s expect on\n"
+        "+2s expect off\n");
+
+    // Still goes off when the main loop is held up over the power off frame
+    run("14399s stall 2s\n"
+        "+1s expect on\n"
+        "+2s expect off\n",
+        4);
+}
+
+void test_menus(void)
+{
+    run("1s click\n"
+        "+1s expect effect 1\n"
+        "+1s click\n"
+        "+1s expect effect 2\n"
+        "+1s expect menu main\n"
+        // Long press into the brightness menu, then each short press is a level down, wrapping back to the top
+        "+1s hold 1s\n"
+        "+2s expect menu bright\n"
+        "+1s click\n"
+        "+1s expect bright 5\n"
+        "+1s click\n"
+        "+1s click\n"
+        "+1s click\n"
+        "+1s click\n"
+        "+1s click\n"
+        "+1s expect bright 0\n"
+        "+1s click\n"
+        "+1s expect bright 6\n"
+        "+1s click\n"
+        "+1s hold 1s\n"
+        "+2s expect menu main\n"
+        "+0 expect bright 5\n"
+        "+0 expect effect 2\n"
+        // and the effect steps on from where it was
+        "+1s click\n"
+        "+1s expect effect 3\n");
+
+    // Round the whole lineup
+    std::string scenario;
+    for (auto i = 0U; i < effects.size(); i++)
+        scenario += "+1s click\n";
+    run((scenario + "+1s expect effect 4\n").c_str(), 4);
+}
+
+void test_power_press(void)
+{
+    // Held for the power press, it fades out, and powers off shortly after it's let go
+    Timewarp tw;
+    std::vector<timewarp_step_t> steps;
+    parse_scenario("1s press\n"
+                   "+4s expect on\n",
+        steps);
+    TEST_ASSERT_EQUAL(0, tw.run(steps).size());
+    TEST_ASSERT_EQUAL_PTR(&overlay, &tw.loop.draw_frame.get());
+    steps.clear();
+    parse_scenario("5s release\n"
+                   "+1 expect on\n"
+                   "+1s expect off\n",
+        steps);
+    TEST_ASSERT_EQUAL(0, tw.run(steps).size());
+    TEST_ASSERT_EQUAL(FPS * 5 + 1 + DEBOUNCE_DELAY, tw.off_frame);
+
+    // Not quite long enough is a long press, which leaves it on
+    run("1s hold 2.9s\n"
+        "+1m expect on\n"
+        "+0 expect menu bright\n");
+}
+
+void test_held_at_power_up(void)
+{
+    // The press that woke us up isn't acted on
+    std::vector<timewarp_step_t> steps;
+    parse_scenario("2s release\n"
+                   "+1s expect on\n"
+                   "+0 expect effect 0\n",
+        steps);
+    Timewarp tw;
+    tw.button.start(true);
+    TEST_ASSERT_EQUAL(0, tw.run(steps).size());
+}
+
+void test_deadline(void)
+{
+    // An effect that can't keep up is slowed down a step each time it falls behind...
+    Timewarp tw;
+    std::vector<timewarp_step_t> steps;
+    parse_scenario("1s stall 0.5s\n"
+                   "+1s expect effect 0\n",
+        steps);
+    TEST_ASSERT_EQUAL(0, tw.run(steps).size());
+    TEST_ASSERT_EQUAL(1, tw.loop.deadline.shift);
+    TEST_ASSERT_EQUAL(1, tw.loop.deadline.events[DeadlineGovernor::NO_GAMMA]);
+    TEST_ASSERT_EQUAL(1, tw.loop.deadline.events[DeadlineGovernor::HALF_RATE]);
+    // ...with the keyframes it pushes slowed to match
+    TEST_ASSERT_EQUAL(tw.loop.draw_frame.get().keyframe_shift() + 1, tw.keyframe_shift);
+
+    steps.clear();
+    parse_scenario("3s stall 0.5s\n"
+                   "+1s expect effect 0\n",
+        steps);
+    TEST_ASSERT_EQUAL(0, tw.run(steps).size());
+    TEST_ASSERT_EQUAL(DEADLINE_MAX_SHIFT, tw.loop.deadline.shift);
+
+    // and it comes back up a step at a time once it keeps up
+    steps.clear();
+    parse_scenario("35s expect effect 0\n", steps);
+    TEST_ASSERT_EQUAL(0, tw.run(steps).size());
+    TEST_ASSERT_EQUAL(DEADLINE_MAX_SHIFT - 1, tw.loop.deadline.shift);
+
+    // Still late at the lowest rate, and it's switched for the next one
+    run("1s stall 0.5s\n"
+        "+1s stall 0.5s\n"
+        "+1s stall 0.5s\n"
+        "+1s expect effect 1\n");
+
+    // but not from under a menu, and that isn't counted as a switch
+    Timewarp menu;
+    steps.clear();
+    parse_scenario("1s hold 1s\n"
+                   "+2s stall 0.5s\n"
+                   "+1s stall 0.5s\n"
+                   "+1s stall 0.5s\n"
+                   "+1s expect effect 0\n"
+                   "+0 expect menu bright\n",
+        steps);
+    TEST_ASSERT_EQUAL(0, menu.run(steps).size());
+    TEST_ASSERT_EQUAL(DEADLINE_MAX_SHIFT, menu.loop.deadline.shift);
+    TEST_ASSERT_EQUAL(0, menu.loop.deadline.events[DeadlineGovernor::SWITCH]);
+}
+
+// HALF_RATE slows the keyframes, not the animation: drawn half as often, an effect gets as far in the same time
+void test_half_rate_speed(void)
+{
+    // Moving on every 16 frames, a whole number of calls at either rate, so the two line up exactly
+    using chase_t = Chase<mbi_t, decltype(LED_ORDER)::const_iterator>;
+    chase_t full(LED_ORDER.begin(), LED_ORDER.end(), 16, mbi_t::N_LEDS);
+    chase_t half(LED_ORDER.begin(), LED_ORDER.end(), 16, mbi_t::N_LEDS);
+
+    // Frames drawn by the main loop, with the deadline governor at `shift`
+    auto draws = [](chase_t& chase, const uint8_t shift) {
+        Timewarp tw;
+        tw.loop.draw_frame = chase;
+        tw.loop.deadline.shift = shift;
+        std::vector<mbi_t::fb_t> out;
+        while (tw.frame < DEADLINE_RECOVER_FRAMES / 2) {
+            bool draw = !tw.frame_drawn && tw.mbi.keyframe_due();
+            tw.tick();
+            if (draw)
+                out.push_back(tw.mbi.get_buffer());
+        }
+        TEST_ASSERT_EQUAL(shift, tw.loop.deadline.shift);
+        return out;
+    };
+    auto every = draws(full, 0);
+    auto every_other = draws(half, 1);
+    TEST_ASSERT_UINT_WITHIN(1, every.size() / 2, every_other.size());
+    // Chase steps before it draws, so a call covering two frames shows the second
+    for (auto k = 0U; 2 * k + 1 < every.size(); k++)
+        TEST_ASSERT(every[2 * k + 1] == every_other[k]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parse);
+    RUN_TEST(test_apo);
+    RUN_TEST(test_menus);
+    RUN_TEST(test_power_press);
+    RUN_TEST(test_held_at_power_up);
+    RUN_TEST(test_deadline);
+    RUN_TEST(test_half_rate_speed);
+    return UNITY_END();
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "MainLoop.h"
+
+// Runs MainLoop on virtual frames as fast as the PC can draw them, with the button driven by a script, for the main
+// loop test and tools/timewarp.cpp. Each frame is the SysTick handler's work (keyframes and the output stage),
+// then the button edges due that frame as the debounce timer would report them, then a pass of the main loop as
+// main.cpp makes it, unless it's been stalled to act out an overrunning effect. The hardware around the main loop
+// (supply sampling, clock scaling, streaming) isn't run.
+//
+// Scenarios are one step per line, `<time> <action>`, with # comments. Times are frames, or seconds, minutes or hours
+// with an s, m or h suffix, and are from power on, or after the previous step with a leading +. Actions:
+//   press, release     the button goes down or up
+//   click              press and release after CLICK_FRAMES
+//   hold <time>        press and release after <time>
+//   stall <time>       the main loop doesn't get to run for <time>, as if an effect took that long to draw a frame
+//   expect on          still running
+//   expect off         powered off by now
+//   expect effect <n>  effect n of the lineup is selected
+//   expect menu main   or bright
+//   expect bright <n>  cur_bright is n
+// e.g. a long press into the brightness menu, down one level and out again:
+//   1s hold 1s
+//   +2s click
+//   +1s expect bright 5
+//   +1s hold 1s
+//   +2s expect menu main
+
+constexpr uint32_t CLICK_FRAMES = FPS / 10;
+
+struct timewarp_step_t {
+    enum action_t : uint8_t { PRESS, RELEASE, STALL, EXPECT_ON, EXPECT_OFF, EXPECT_EFFECT, EXPECT_MENU, EXPECT_BRIGHT };
+    uint32_t frame;
+    action_t action;
+    uint32_t arg;
+    uint16_t line;
+};
+
+// A time in frames, `at` is the time of the previous step
+inline bool parse_time(const std::string& s, const uint32_t at, uint32_t& frame)
+{
+    bool relative = !s.empty() && s[0] == '+';
+    char* end;
+    double v = std::strtod(s.c_str() + relative, &end);
+    if (end == s.c_str() + relative)
+        return false;
+    switch (*end) {
+    case 'h':
+        v *= 60;
+        [[fallthrough]];
+    case 'm':
+        v *= 60;
+        [[fallthrough]];
+    case 's':
+        v *= FPS;
+        end++;
+        break;
+    }
+    if (*end)
+        return false;
+    frame = static_cast<uint32_t>(v + 0.5) + (relative ? at : 0);
+    return true;
+}
+
+// Parse a scenario into steps, in time order. Returns the line of the first error, 0 if none.
+inline uint16_t parse_scenario(const std::string& text, std::vector<timewarp_step_t>& steps)
+{
+    std::istringstream in(text);
+    std::string line;
+    uint32_t at = 0;
+    for (uint16_t n = 1; std::getline(in, line); n++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream ls(line);
+        std::string time, action, arg;
+        if (!(ls >> time))
+            continue;
+        if (!parse_time(time, at, at) || !(ls >> action))
+            return n;
+        ls >> arg;
+
+        auto add = [&](const uint32_t frame, const timewarp_step_t::action_t a, const uint32_t v = 0) {
+            steps.push_back({ frame, a, v, n });
+        };
+        uint32_t len;
+        if (action == "press") {
+            add(at, timewarp_step_t::PRESS);
+        } else if (action == "release") {
+            add(at, timewarp_step_t::RELEASE);
+        } else if (action == "click") {
+            add(at, timewarp_step_t::PRESS);
+            add(at + CLICK_FRAMES, timewarp_step_t::RELEASE);
+        } else if (action == "hold" && parse_time(arg, 0, len)) {
+            add(at, timewarp_step_t::PRESS);
+            add(at + len, timewarp_step_t::RELEASE);
+        } else if (action == "stall" && parse_time(arg, 0, len)) {
+            add(at, timewarp_step_t::STALL, len);
+        } else if (action == "expect") {
+            std::string v;
+            ls >> v;
+            if (arg == "on")
+                add(at, timewarp_step_t::EXPECT_ON);
+            else if (arg == "off")
+                add(at, timewarp_step_t::EXPECT_OFF);
+            else if (arg == "effect" && !v.empty())
+                add(at, timewarp_step_t::EXPECT_EFFECT, std::stoul(v));
+            else if (arg == "bright" && !v.empty())
+                add(at, timewarp_step_t::EXPECT_BRIGHT, std::stoul(v));
+            else if (arg == "menu" && (v == "main" || v == "bright"))
+                add(at, timewarp_step_t::EXPECT_MENU, v == "main" ? MainLoop::MAIN : MainLoop::BRIGHT);
+            else
+                return n;
+        } else {
+            return n;
+        }
+    }
+    std::stable_sort(steps.begin(), steps.end(),
+        [](const timewarp_step_t& a, const timewarp_step_t& b) { return a.frame < b.frame; });
+    return 0;
+}
+
+struct Timewarp {
+    mbi_t mbi { (1 << (6 + 9)) - 1 };
+    Button button;
+    MainLoop loop { mbi, button };
+
+    uint32_t frame = 0;
+    // Frame the main loop asked to power off at, 0 while running
+    uint32_t off_frame = 0;
+
+    // The main loop doesn't run before this frame
+    uint32_t stall_until = 0;
+
+    bool frame_drawn = true;
+    uint8_t keyframe_shift = 0;
+
+    Timewarp(const uint8_t effect = 0)
+    {
+        effect_rng = pcg();
+        mbi.clear_buffers();
+        button.start(false);
+        loop.set_effect(effect);
+        // The main loop gets to draw the first frame before SysTick is first due
+        keyframe_shift = loop.draw(frame);
+        frame_drawn = false;
+    }
+
+    // One frame: SysTick, then the main loop
+    void tick()
+    {
+        bool late = frame_drawn && mbi.keyframe_due();
+        if (!frame_drawn && mbi.keyframe_due()) {
+            mbi.push_keyframe(keyframe_shift);
+            frame_drawn = true;
+        }
+        loop.deadline.tick(late, keyframe_shift);
+        // Nothing looks at the output values, only at the keyframe timing, so always skip the gamma curve
+        if (!mbi.keyframe_due()) {
+            loop.deadline.skip_gamma();
+            mbi.correct_frame<false>();
+        }
+        frame++;
+
+        if (off_frame || !frame_reached(frame, stall_until))
+            return;
+        if (frame_drawn) {
+            keyframe_shift = loop.draw(frame);
+            frame_drawn = false;
+        }
+        if (!loop.step(frame, false))
+            off_frame = frame;
+    }
+
+    // Run a scenario's steps to the last one, returning the failed expectations as "line n: what"
+    std::vector<std::string> run(const std::vector<timewarp_step_t>& steps)
+    {
+        std::vector<std::string> failures;
+        auto fail = [&](const timewarp_step_t& s, const std::string& what) {
+            failures.push_back("line " + std::to_string(s.line) + ": " + what);
+        };
+        for (auto& s : steps) {
+            while (frame < s.frame)
+                tick();
+            switch (s.action) {
+            case timewarp_step_t::PRESS:
+            case timewarp_step_t::RELEASE:
+                // Edges land between frames, as the debounce timer's do
+                button.edge(s.action == timewarp_step_t::PRESS, frame);
+                break;
+            case timewarp_step_t::STALL:
+                stall_until = frame + s.arg;
+                break;
+            case timewarp_step_t::EXPECT_ON:
+                if (off_frame)
+                    fail(s, "powered off at frame " + std::to_string(off_frame));
+                break;
+            case timewarp_step_t::EXPECT_OFF:
+                if (!off_frame)
+                    fail(s, "still on");
+                break;
+            case timewarp_step_t::EXPECT_EFFECT:
+                if (loop.cur_effect != s.arg)
+                    fail(s, "effect is " + std::to_string(loop.cur_effect));
+                break;
+            case timewarp_step_t::EXPECT_MENU:
+                if (loop.menu_state != s.arg)
+                    fail(s, loop.menu_state == MainLoop::MAIN ? "menu is main" : "menu is bright");
+                break;
+            case timewarp_step_t::EXPECT_BRIGHT:
+                if (loop.cur_bright != s.arg)
+                    fail(s, "bright is " + std::to_string(loop.cur_bright));
+                break;
+            }
+        }
+        return failures;
+    }
+};
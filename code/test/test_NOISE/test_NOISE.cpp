@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include <unity.h>
+
+#include "SimMBI.h"
+
+#include "Noise.h"
+
+using sim_t = SimMBI<NUM_LEDS>;
+
+void test_permutation(void)
+{
+    uint8_t seen[256] = {};
+    for (auto v : noise::PERM)
+        seen[v]++;
+    for (auto n : seen)
+        TEST_ASSERT_EQUAL(1, n);
+
+    TEST_ASSERT_EQUAL(0, noise::smooth(0));
+    TEST_ASSERT_EQUAL(128, noise::smooth(128));
+    TEST_ASSERT_EQUAL(255, noise::smooth(255));
+}
+
+void test_value(void)
+{
+    // Grid points are the lattice values, and it's continuous across cells
+    for (uint32_t x = 0; x < 0x10000; x += 0x100)
+        TEST_ASSERT_EQUAL(noise::lattice(x >> 8, 3) << 8, noise::value(x, 3));
+    uint32_t total = 0;
+    for (uint32_t x = 0; x < 0x10000; x++) {
+        auto v = noise::value(x), next = noise::value(x + 1);
+        TEST_ASSERT(std::abs(next - v) <= 2 * 255);
+        total += v;
+    }
+    // Centred
+    TEST_ASSERT_UINT_WITHIN(0x800, 0x8000, total >> 16);
+
+    // Rows are unrelated
+    uint8_t same = 0;
+    for (uint8_t row = 1; row < 16; row++)
+        same += noise::value(0x1280, row) == noise::value(0x1280, 0);
+    TEST_ASSERT(same < 2);
+}
+
+void test_value2(void)
+{
+    for (uint32_t y = 0; y < 0x10000; y += 0x100)
+        for (uint32_t x = 0; x < 0x10000; x += 0x100)
+            TEST_ASSERT_EQUAL(noise::lattice(x >> 8, y >> 8) << 8, noise::value2(x, y));
+    // Along a grid line it's the 1D noise for that row
+    for (uint32_t x = 0; x < 0x10000; x += 7)
+        TEST_ASSERT_EQUAL(noise::value(x, 5), noise::value2(x, 5 << 8));
+    for (uint32_t y = 0; y < 0x10000; y += 3) {
+        auto v = noise::value2(0x4321, y), next = noise::value2(0x4321, y + 1);
+        TEST_ASSERT(std::abs(next - v) <= 2 * 255);
+    }
+}
+
+void test_noise_twinkle(void)
+{
+    // Stays in the same range as Twinkle, moving smoothly, and every LED differently
+    sim_t mbi;
+    auto twinkle = NoiseTwinkle<sim_t>(sim_t::LED_MAX / 4, 20);
+    twinkle(mbi, 0);
+    auto prev = mbi.buffer;
+    uint32_t moved = 0;
+    for (uint32_t f = 1; f < 20000; f++) {
+        twinkle(mbi, f);
+        for (auto i = 0U; i < NUM_LEDS; i++) {
+            TEST_ASSERT(mbi.buffer[i] >= sim_t::LED_MAX / 4 - 1 && mbi.buffer[i] <= sim_t::LED_MAX * 3 / 4 + 1);
+            TEST_ASSERT(std::abs(mbi.buffer[i] - prev[i]) < sim_t::LED_MAX / 20);
+            moved += mbi.buffer[i] != prev[i];
+        }
+        TEST_ASSERT(std::count(mbi.buffer.begin(), mbi.buffer.end(), mbi.buffer[0]) < NUM_LEDS);
+        prev = mbi.buffer;
+    }
+    TEST_ASSERT(moved > 20000 * NUM_LEDS * 3 / 4);
+
+    // The same frame always looks the same
+    auto again = NoiseTwinkle<sim_t>(sim_t::LED_MAX / 4, 20);
+    again(mbi, 12345);
+    prev = mbi.buffer;
+    twinkle(mbi, 12345);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(prev.data(), mbi.buffer.data(), NUM_LEDS);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_permutation);
+    RUN_TEST(test_value);
+    RUN_TEST(test_value2);
+    RUN_TEST(test_noise_twinkle);
+    return UNITY_END();
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+
+#include "OpCount.h"
+#include "OutputStage.h"
+#include "SimMBI.h"
+
+#include "Effects.h"
+#include "Script.h"
+#include "Scripts.h"
+#include "Spatial.h"
+
+// Counted runs of the output stage and the effects that divide or draw random numbers, for test_OPCOUNT's budget
+// checks and the M0 estimates tools/bench.cpp reports (--m0). The effects are made as in EffectSetup.h but with counted
+// word types, and called every frame (frame_shift 0), so the counts are per call.
+
+// The output stage with its correction exposed
+template <class px_t> struct Stage : OutputStage<NUM_LEDS, px_t> {
+    explicit Stage(const uint16_t bright)
+        : OutputStage<NUM_LEDS, px_t>(bright)
+    {
+    }
+    using OutputStage<NUM_LEDS, px_t>::apply_correction;
+};
+
+namespace opcount {
+using sim_t = SimMBI<NUM_LEDS>;
+
+// Calls counted per effect, enough for Twinkle's targets and RandomChase's shuffles to come round several times
+constexpr uint32_t EFFECT_CALLS = 2000;
+
+// Draws taken from effect_rng since it was `before`, stepping a copy along until it catches up
+inline uint32_t draws(pcg before)
+{
+    uint32_t n = 0;
+    for (; before != effect_rng && n < UINT16_MAX; n++)
+        before();
+    return n;
+}
+
+// Counts over EFFECT_CALLS calls of f(mbi, frame), RNG draws included
+template <class F> counts_t count_calls(F f)
+{
+    sim_t mbi;
+    reset();
+    for (uint32_t frame = 0; frame < EFFECT_CALLS; frame++) {
+        pcg before = effect_rng;
+        f(mbi, frame);
+        tally[RNG] += draws(before);
+    }
+    return tally;
+}
+
+template <class E> counts_t count_effect(E&& effect)
+{
+    return count_calls([&](sim_t& mbi, const uint32_t frame) { effect(mbi, frame); });
+}
+
+// TwinkleTwinkle, a division per LED
+inline counts_t twinkle_counts()
+{
+    effect_rng = pcg();
+    return count_effect(Twinkle<sim_t, counted<int32_t>>((sim_t::LED_MAX + 1) / 8, 40, 2));
+}
+
+// ChaseRandom, a shuffle every N_LEDS * 20 frames
+inline counts_t random_chase_counts()
+{
+    effect_rng = pcg();
+    return count_effect(RandomChase<sim_t, counted<uint32_t>>(20, sim_t::N_LEDS));
+}
+
+// Bursts
+inline counts_t starburst_counts()
+{
+    effect_rng = pcg();
+    constexpr auto MAX = sim_t::LED_MAX;
+    return count_effect(StarBurst<sim_t, counted<int32_t>>(FPS, MAX / 8, MAX / 64, MAX / 4));
+}
+
+// A script's frames in the VM, run() and step(): a division per ramp started
+template <size_t len> counts_t script_counts(const uint8_t (&code)[len])
+{
+    effect_rng = pcg();
+    ScriptVM<NUM_LEDS, counted<int32_t>> vm;
+    vm.load(code, len);
+    return count_calls([&](sim_t&, uint32_t) { vm.frame(); });
+}
+}
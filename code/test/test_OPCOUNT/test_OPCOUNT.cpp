@@ -0,0 +1,179 @@
+#include <cstdint>
+#include <limits>
+
+#include <unity.h>
+
+#include "opcount_run.h"
+
+using namespace opcount;
+
+// The M0's share of a frame
+constexpr uint32_t FRAME_CYCLES = F_CPU / FPS;
+
+// Estimated M0 cycles for a frame's worth of corrections, over a spread of values
+template <class px_t, bool gamma_corrected, uint8_t frac_bits, bool calibrated = ENABLE_CALIBRATION>
+uint32_t frame_cycles(counts_t& counts)
+{
+    Stage<px_t> stage(UINT16_MAX / 2);
+    reset();
+    for (auto i = 0U; i < NUM_LEDS; i++) {
+        px_t val = (i + 1) * (std::numeric_limits<px_t>::max() / NUM_LEDS);
+        auto plain = stage.template apply_correction<gamma_corrected, frac_bits, calibrated>(val, i);
+        auto c = stage.template apply_correction<gamma_corrected, frac_bits, calibrated, counted<uint32_t>,
+            counted<float>>(val, i);
+        // Counting doesn't change the answer
+        TEST_ASSERT_EQUAL(plain, c.v);
+    }
+    counts = tally;
+    return cycles(tally);
+}
+
+void test_counting(void)
+{
+    reset();
+    counted<int32_t> a = 3, b = 4;
+    auto c = a * b + a - 1;
+    TEST_ASSERT_EQUAL(14, c.v);
+    TEST_ASSERT_EQUAL(1, tally[MUL]);
+    TEST_ASSERT_EQUAL(2, tally[ALU]);
+    c /= 2;
+    TEST_ASSERT_EQUAL(7, c.v);
+    TEST_ASSERT_EQUAL(1, tally[DIV]);
+
+    // A counted integer used in float maths is converted, a constant isn't
+    reset();
+    counted<float> f = 1.5F;
+    auto g = f * a + 2;
+    TEST_ASSERT_EQUAL_FLOAT(6.5F, g.v);
+    TEST_ASSERT_EQUAL(1, tally[FMUL]);
+    TEST_ASSERT_EQUAL(1, tally[FADD]);
+    TEST_ASSERT_EQUAL(1, tally[FCONV]);
+    TEST_ASSERT(g > 6);
+    TEST_ASSERT_EQUAL(2, tally[FADD]);
+    TEST_ASSERT_EQUAL(6, static_cast<int32_t>(g));
+    TEST_ASSERT_EQUAL(2, tally[FCONV]);
+
+    reset();
+    counted<uint64_t> w = 1ULL << 40;
+    w = w * 3 + (w >> 8);
+    TEST_ASSERT_EQUAL(1, tally[WIDE_MUL]);
+    TEST_ASSERT_EQUAL(2, tally[WIDE_ALU]);
+    TEST_ASSERT_EQUAL(0, tally[MUL] + tally[ALU]);
+    TEST_ASSERT_EQUAL(M0_CYCLES[WIDE_MUL] + 2 * M0_CYCLES[WIDE_ALU], cycles(tally));
+}
+
+void test_correction16(void)
+{
+    counts_t counts;
+    auto gamma = frame_cycles<uint16_t, true, 8>(counts);
+    // The float curve goes without division, as the comment in apply_correction promises
+    TEST_ASSERT_EQUAL(0, counts[FDIV] + counts[DIV] + counts[WIDE_DIV]);
+    TEST_ASSERT(counts[FMUL] > 0);
+    // About 8% of the frame, says the same comment
+    TEST_ASSERT(gamma < FRAME_CYCLES / 10);
+
+    auto linear = frame_cycles<uint16_t, false, 8>(counts);
+    TEST_ASSERT_EQUAL(0, counts[FADD] + counts[FMUL] + counts[FCONV]);
+    TEST_ASSERT(linear < gamma / 20);
+}
+
+void test_correction8(void)
+{
+    // With 8-bit pixels the gamma curve is a table, no float at all
+    counts_t counts;
+    auto gamma = frame_cycles<uint8_t, true, 8>(counts);
+    TEST_ASSERT_EQUAL(0, counts[FADD] + counts[FMUL] + counts[FDIV] + counts[FCONV]);
+    TEST_ASSERT_EQUAL(0, counts[DIV] + counts[WIDE_DIV]);
+    TEST_ASSERT(gamma <= 4 * NUM_LEDS);
+
+    counts_t counts16;
+    auto gamma16 = frame_cycles<uint16_t, true, 8>(counts16);
+    TEST_ASSERT(gamma < gamma16 / 50);
+}
+
+// Calibration costs a shift and an add per LED, its gain rides along on bright's multiply
+template <class px_t> void check_calibration_cost()
+{
+    counts_t with, without;
+    auto cal = frame_cycles<px_t, true, 8, true>(with);
+    auto uncal = frame_cycles<px_t, true, 8, false>(without);
+    TEST_ASSERT_EQUAL(without[MUL], with[MUL]);
+    TEST_ASSERT_EQUAL(without[ALU] + 2 * NUM_LEDS, with[ALU]);
+    TEST_ASSERT_EQUAL(2 * NUM_LEDS * M0_CYCLES[ALU], cal - uncal);
+}
+
+void test_calibration_cost(void)
+{
+    check_calibration_cost<uint16_t>();
+    check_calibration_cost<uint8_t>();
+}
+
+// Effects get a hundredth of a frame each, the output stage's correction is what takes the time
+constexpr uint32_t EFFECT_BUDGET = FRAME_CYCLES / 100 * EFFECT_CALLS;
+
+void test_twinkle(void)
+{
+    auto counts = twinkle_counts();
+    // A division per LED that's between targets, and they're 10-40 frames apart
+    TEST_ASSERT(counts[DIV] <= NUM_LEDS * EFFECT_CALLS);
+    TEST_ASSERT(counts[DIV] > NUM_LEDS * EFFECT_CALLS * 3 / 4);
+    // Which is most of what it costs, two draws per target included
+    TEST_ASSERT(counts[DIV] * M0_CYCLES[DIV] > cycles(counts) / 2);
+    TEST_ASSERT(counts[RNG] < NUM_LEDS * EFFECT_CALLS / 5);
+    TEST_ASSERT(cycles(counts) < EFFECT_BUDGET);
+}
+
+void test_random_chase(void)
+{
+    auto counts = random_chase_counts();
+    TEST_ASSERT_EQUAL(0, counts[DIV] + counts[WIDE_DIV]);
+    // A shuffle, fewer than NUM_LEDS draws, every 20 * NUM_LEDS calls
+    TEST_ASSERT(counts[RNG] <= (EFFECT_CALLS / (20 * NUM_LEDS) + 1) * NUM_LEDS);
+    TEST_ASSERT(cycles(counts) < EFFECT_BUDGET);
+}
+
+void test_starburst(void)
+{
+    auto counts = starburst_counts();
+    // Compares and adds only
+    TEST_ASSERT_EQUAL(0, counts[MUL] + counts[DIV] + counts[WIDE_DIV]);
+    // A burst, one draw for where, every FPS calls
+    TEST_ASSERT_UINT_WITHIN(1, EFFECT_CALLS / FPS, counts[RNG]);
+    TEST_ASSERT(cycles(counts) < EFFECT_BUDGET);
+}
+
+void test_script(void)
+{
+    // Stepping ramps is a multiply and adds, the divide is done once when a ramp starts
+    ScriptVM<NUM_LEDS, counted<int32_t>> vm;
+    vm.load(scripts::comet, sizeof(scripts::comet));
+    vm.frame();
+    reset();
+    vm.step();
+    TEST_ASSERT_EQUAL(0, tally[DIV]);
+    TEST_ASSERT(tally[MUL] > 0);
+
+    // The comet starts three ramps every 6 frames
+    auto counts = script_counts(scripts::comet);
+    TEST_ASSERT_UINT_WITHIN(3, EFFECT_CALLS / 2, counts[DIV]);
+    TEST_ASSERT(cycles(counts) < EFFECT_BUDGET);
+
+    // The sparkle picks an LED (a draw and a remainder) every 7 frames after a 30 frame fade in
+    counts = script_counts(scripts::sparkle);
+    TEST_ASSERT_UINT_WITHIN(1, (EFFECT_CALLS - 30) / 7 + 1, counts[RNG]);
+    TEST_ASSERT(cycles(counts) < EFFECT_BUDGET);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_counting);
+    RUN_TEST(test_correction16);
+    RUN_TEST(test_correction8);
+    RUN_TEST(test_calibration_cost);
+    RUN_TEST(test_twinkle);
+    RUN_TEST(test_random_chase);
+    RUN_TEST(test_starburst);
+    RUN_TEST(test_script);
+    return UNITY_END();
+}
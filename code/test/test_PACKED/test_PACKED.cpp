@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+
+#include <unity.h>
+
+#include "SimMBI.h"
+
+#include "Effects.h"
+#include "Packed.h"
+
+using sim_t = SimMBI<NUM_LEDS>;
+using chase_t = Chase<sim_t, decltype(LED_ORDER)::const_iterator>;
+
+uint32_t pack(const uint16_t lo, const uint16_t hi) { return lo | static_cast<uint32_t>(hi) << 16; }
+
+// Lane values that hit the edge cases, plus random ones
+template <class F> void for_pairs(F f)
+{
+    const uint16_t edges[] = { 0, 1, 0xff, 0x100, 0x7fff, 0x8000, 0x8001, 0xfffe, 0xffff };
+    for (auto a : edges)
+        for (auto b : edges)
+            for (auto c : edges)
+                for (auto d : edges)
+                    f(a, b, c, d);
+    std::mt19937 gen(2);
+    std::uniform_int_distribution<uint16_t> dist;
+    for (auto i = 0; i < 100000; i++)
+        f(dist(gen), dist(gen), dist(gen), dist(gen));
+}
+
+void test_add_wraps(void)
+{
+    for_pairs([](uint16_t a0, uint16_t a1, uint16_t b0, uint16_t b1) {
+        uint32_t r = packed::add<uint16_t>(pack(a0, a1), pack(b0, b1));
+        TEST_ASSERT_EQUAL(static_cast<uint16_t>(a0 + b0), r & 0xffff);
+        TEST_ASSERT_EQUAL(static_cast<uint16_t>(a1 + b1), r >> 16);
+    });
+}
+
+void test_min(void)
+{
+    for_pairs([](uint16_t a0, uint16_t a1, uint16_t b0, uint16_t b1) {
+        uint32_t r = packed::min<uint16_t>(pack(a0, a1), pack(b0, b1));
+        TEST_ASSERT_EQUAL(std::min(a0, b0), r & 0xffff);
+        TEST_ASSERT_EQUAL(std::min(a1, b1), r >> 16);
+    });
+}
+
+void test_scale(void)
+{
+    for (uint16_t k : { 0, 1, 100, 128, 255, 256 })
+        for_pairs([k](uint16_t a0, uint16_t a1, uint16_t, uint16_t) {
+            uint32_t r = packed::scale<uint16_t>(pack(a0, a1), k);
+            TEST_ASSERT_EQUAL((static_cast<uint32_t>(a0) * k) >> 8, r & 0xffff);
+            TEST_ASSERT_EQUAL((static_cast<uint32_t>(a1) * k) >> 8, r >> 16);
+        });
+}
+
+void test_apply_unary(void)
+{
+    // Odd length, the last LED is done on its own
+    alignas(4) std::array<uint16_t, 5> a { 1, 2, 65535, 4, 65534 };
+    packed::apply(a, [s = packed::splat<uint16_t>(2)](uint32_t v) { return packed::add_sat<uint16_t>(v, s); });
+    const uint16_t expect[] = { 3, 4, 65535, 6, 65535 };
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expect, a.data(), 5);
+}
+
+// Check a kernel on 8-bit lanes against the scalar version on each of the four lanes
+template <class P, class S> void check_kernel8(P packed_f, S scalar_f)
+{
+    auto check = [&](uint32_t a, uint32_t b) {
+        uint32_t r = packed_f(a, b);
+        for (auto s = 0U; s < 32; s += 8)
+            TEST_ASSERT_EQUAL(scalar_f((a >> s) & 0xff, (b >> s) & 0xff) & 0xff, (r >> s) & 0xff);
+    };
+    const uint8_t edges[] = { 0, 1, 0x7f, 0x80, 0x81, 0xfe, 0xff };
+    for (auto a : edges)
+        for (auto b : edges)
+            check(uint32_t(a) * 0x01010101u ^ 0x00ff00ffu, uint32_t(b) * 0x01010101u);
+    std::mt19937 gen(3);
+    for (auto i = 0; i < 100000; i++)
+        check(gen(), gen());
+}
+
+void test_kernels8(void)
+{
+    check_kernel8(packed::add<uint8_t>, [](uint32_t a, uint32_t b) { return a + b; });
+    check_kernel8(packed::add_sat<uint8_t>, [](uint32_t a, uint32_t b) { return std::min(a + b, 255U); });
+    check_kernel8(packed::sub_sat<uint8_t>, [](uint32_t a, uint32_t b) { return a > b ? a - b : 0; });
+    check_kernel8(packed::max<uint8_t>, [](uint32_t a, uint32_t b) { return std::max(a, b); });
+    check_kernel8(packed::min<uint8_t>, [](uint32_t a, uint32_t b) { return std::min(a, b); });
+    check_kernel8(packed::mul<uint8_t>, [](uint32_t a, uint32_t b) { return (a * (b + 1)) >> 8; });
+    for (uint16_t k : { 0, 1, 100, 128, 255, 256 }) {
+        check_kernel8([k](uint32_t a, uint32_t) { return packed::scale<uint8_t>(a, k); },
+            [k](uint32_t a, uint32_t) { return (a * k) >> 8; });
+        check_kernel8([k](uint32_t a, uint32_t b) { return packed::lerp<uint8_t>(a, b, k); },
+            [k](uint32_t a, uint32_t b) { return (a * (256 - k) + b * k) >> 8; });
+    }
+}
+
+void test_apply8(void)
+{
+    // Four LEDs per word, the last three on their own
+    alignas(4) std::array<uint8_t, 7> a { 1, 2, 255, 4, 5, 254, 7 };
+    packed::apply(a, [s = packed::splat<uint8_t>(2)](uint32_t v) { return packed::add_sat<uint8_t>(v, s); });
+    const uint8_t expect[] = { 3, 4, 255, 6, 7, 255, 9 };
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expect, a.data(), 7);
+}
+
+// FNV-1a over every frame of an effect
+uint32_t run_hash(MBIEffect<sim_t>& effect)
+{
+    sim_t mbi;
+    uint32_t h = 2166136261;
+    for (uint32_t f = 0; f < 5000; f++) {
+        effect(mbi, f);
+        for (auto v : mbi.buffer)
+            h = (h ^ v) * 16777619;
+    }
+    return h;
+}
+
+// The effects' output is unchanged from their scalar loops: these hashes were recorded from the per-LED versions,
+// with the same parameters as the instances in EffectSetup.h
+void test_effects_unchanged(void)
+{
+    struct {
+        const char* name;
+        uint32_t hash;
+        std::function<std::unique_ptr<MBIEffect<sim_t>>()> make;
+    } cases[] = {
+        { "ChaseAround", 0x0521cac5,
+            [] { return std::make_unique<chase_t>(LED_ORDER.begin(), LED_ORDER.end(), 120, 3); } },
+        { "ChaseBack", 0xc40a2646,
+            [] {
+                return std::make_unique<chase_t>(LED_ORDER.begin(), LED_ORDER.end(), 15, sim_t::N_LEDS, chase_t::DOWN);
+            } },
+        { "FastChase", 0xa545b685,
+            [] { return std::make_unique<chase_t>(LED_ORDER.begin(), LED_ORDER.end(), 5, 1, chase_t::DOWN); } },
+        { "ChaseRandom", 0xa66fb2fc, [] { return std::make_unique<RandomChase<sim_t>>(20, sim_t::N_LEDS); } },
+        { "RandomSequence", 0x6ab07fff, [] { return std::make_unique<RandomChase<sim_t>>(5, 1, 0); } },
+        { "RampAllUp", 0xac1a2a55, [] { return std::make_unique<RampAll<sim_t>>(sim_t::LED_MAX / 128); } },
+        { "TwinkleTwinkle", 0x80153ffc, [] { return std::make_unique<Twinkle<sim_t>>(8192, 40, 2); } },
+        { "TwinkleBlinkle", 0x697066ba, [] { return std::make_unique<Twinkle<sim_t>>(INT16_MAX / 2, 20, 1); } },
+    };
+    for (auto& c : cases) {
+        effect_rng = pcg();
+        auto effect = c.make();
+        TEST_ASSERT_EQUAL_HEX32_MESSAGE(c.hash, run_hash(*effect), c.name);
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_add_wraps);
+    RUN_TEST(test_min);
+    RUN_TEST(test_scale);
+    RUN_TEST(test_apply_unary);
+    RUN_TEST(test_kernels8);
+    RUN_TEST(test_apply8);
+    RUN_TEST(test_effects_unchanged);
+    return UNITY_END();
+}
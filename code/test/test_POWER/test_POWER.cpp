@@ -0,0 +1,78 @@
+#include <cstdint>
+#include <iostream>
+
+#include <unity.h>
+
+#include "PowerModel.h"
+
+constexpr uint32_t FULL_ON = NUM_LEDS * UINT16_MAX;
+
+void test_gain(void)
+{
+    TEST_ASSERT_EQUAL(125, mbi_gain_milli(0));
+    TEST_ASSERT_EQUAL(1938, mbi_gain_milli(0b111111));
+    // Base current set by R4 at the default gain
+    TEST_ASSERT_EQUAL(MBI_BASE_CURRENT_UA / 8, PowerModel::LED_FULL_UA);
+}
+
+void test_frame_current(void)
+{
+    TEST_ASSERT_EQUAL(PowerModel::OVERHEAD_UA, PowerModel::supply_ua(0));
+    TEST_ASSERT_UINT_WITHIN(NUM_LEDS, NUM_LEDS * PowerModel::LED_FULL_UA, PowerModel::led_ua(FULL_ON));
+    TEST_ASSERT_UINT_WITHIN(2, PowerModel::LED_FULL_UA / 2, PowerModel::led_ua(UINT16_MAX / 2));
+
+    // Should agree with the 4-7mA measured on the card
+    TEST_ASSERT_GREATER_OR_EQUAL(4000, PowerModel::supply_ua(FULL_ON / 8));
+    TEST_ASSERT_LESS_OR_EQUAL(7000, PowerModel::supply_ua(FULL_ON / 4));
+}
+
+void test_limit(void)
+{
+    TEST_ASSERT_EQUAL(UINT32_MAX, PowerModel::max_out_sum(0));
+    TEST_ASSERT_EQUAL(0, PowerModel::max_out_sum(PowerModel::OVERHEAD_UA));
+
+    // The output sum the limiter allows must never estimate over the limit
+    for (uint32_t limit = PowerModel::OVERHEAD_UA + 1; limit < PowerModel::supply_ua(FULL_ON); limit += 37) {
+        auto max_sum = PowerModel::max_out_sum(limit);
+        TEST_ASSERT_LESS_OR_EQUAL(limit, PowerModel::supply_ua(max_sum));
+        // and shouldn't be needlessly conservative
+        TEST_ASSERT_GREATER_OR_EQUAL(limit - 2, PowerModel::supply_ua(max_sum));
+    }
+}
+
+void test_projection(void)
+{
+    PowerModel pm;
+
+    // One hour at a constant 5mA
+    constexpr uint32_t out_sum = (5000 - PowerModel::OVERHEAD_UA) * FULL_ON / (NUM_LEDS * PowerModel::LED_FULL_UA);
+    for (uint32_t i = 0; i < FPS * 3600; i++)
+        pm.update(out_sum);
+
+    std::cout << "1h at " << pm.average_ua() << "uA: used " << pm.used_uah() << "uAh, " << pm.hours_remaining()
+              << "h remaining\n";
+
+    TEST_ASSERT_UINT_WITHIN(5, 5000, pm.average_ua());
+    TEST_ASSERT_UINT_WITHIN(5, 5000, pm.used_uah());
+    TEST_ASSERT_UINT_WITHIN(1, BATTERY_CAPACITY_MAH / 5 - 1, pm.hours_remaining());
+}
+
+void test_driver_off(void)
+{
+    PowerModel pm;
+    pm.update(0, false);
+    TEST_ASSERT_EQUAL(MCU_CURRENT_UA, pm.average_ua());
+    pm.update(0, true);
+    TEST_ASSERT_EQUAL((MCU_CURRENT_UA + PowerModel::OVERHEAD_UA) / 2, pm.average_ua());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_gain);
+    RUN_TEST(test_frame_current);
+    RUN_TEST(test_limit);
+    RUN_TEST(test_projection);
+    RUN_TEST(test_driver_off);
+    return UNITY_END();
+}
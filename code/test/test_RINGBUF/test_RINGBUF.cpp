@@ -0,0 +1,59 @@
+#include <cstdint>
+
+#include <unity.h>
+
+#include "RingBuffer.h"
+
+void test_fifo_order(void)
+{
+    RingBuffer<uint8_t, 8> rb;
+    TEST_ASSERT_TRUE(rb.empty());
+    for (uint8_t i = 0; i < 5; i++)
+        TEST_ASSERT_TRUE(rb.push(i));
+    TEST_ASSERT_EQUAL(5, rb.size());
+    uint8_t v;
+    for (uint8_t i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(rb.pop(v));
+        TEST_ASSERT_EQUAL(i, v);
+    }
+    TEST_ASSERT_FALSE(rb.pop(v));
+}
+
+void test_full(void)
+{
+    RingBuffer<uint8_t, 8> rb;
+    for (size_t i = 0; i < decltype(rb)::CAPACITY; i++)
+        TEST_ASSERT_TRUE(rb.push(i));
+    TEST_ASSERT_EQUAL(0, rb.space());
+    // Full pushes fail and don't overwrite anything
+    TEST_ASSERT_FALSE(rb.push(99));
+    uint8_t v;
+    TEST_ASSERT_TRUE(rb.pop(v));
+    TEST_ASSERT_EQUAL(0, v);
+    TEST_ASSERT_TRUE(rb.push(7));
+}
+
+void test_wrap(void)
+{
+    RingBuffer<uint16_t, 4> rb;
+    uint16_t v;
+    // Push and pop far more than the size so the indices wrap many times
+    for (uint16_t i = 0; i < 1000; i++) {
+        TEST_ASSERT_TRUE(rb.push(i));
+        TEST_ASSERT_TRUE(rb.push(i + 1));
+        TEST_ASSERT_TRUE(rb.pop(v));
+        TEST_ASSERT_EQUAL(i, v);
+        TEST_ASSERT_TRUE(rb.pop(v));
+        TEST_ASSERT_EQUAL(i + 1, v);
+        TEST_ASSERT_TRUE(rb.empty());
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_order);
+    RUN_TEST(test_full);
+    RUN_TEST(test_wrap);
+    return UNITY_END();
+}
@@ -0,0 +1,132 @@
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include <unity.h>
+
+#include "SimMBI.h"
+
+#include "Script.h"
+
+using sim_t = SimMBI<NUM_LEDS>;
+using vm_t = ScriptVM<NUM_LEDS>;
+
+vm_t load(const std::vector<uint8_t>& code)
+{
+    vm_t vm;
+    vm.load(code.data(), code.size());
+    return vm;
+}
+
+void test_ramp(void)
+{
+    using namespace script;
+    std::vector<uint8_t> code = { SET, ALL, 100, 0, RAMP, 2, 0x10, 0x27, 10, WAIT, 20 };
+    auto vm = load(code);
+    for (auto f = 1; f <= 10; f++) {
+        vm.frame();
+        TEST_ASSERT_EQUAL(100, vm.value[0]);
+        // Linear, arriving exactly on the last frame
+        TEST_ASSERT_UINT_WITHIN(1, 100 + (10000 - 100) * f / 10, vm.value[2]);
+    }
+    TEST_ASSERT_EQUAL(10000, vm.value[2]);
+}
+
+void test_wait_and_restart(void)
+{
+    using namespace script;
+    // Off for 3 frames, on for 2, from the top again
+    std::vector<uint8_t> code = { SET, 0, 0, 0, WAIT, 3, SET, 0, 0xff, 0xff, WAIT, 2 };
+    auto vm = load(code);
+    std::vector<uint16_t> seen;
+    for (auto f = 0; f < 10; f++) {
+        vm.frame();
+        seen.push_back(vm.value[0]);
+    }
+    std::vector<uint16_t> expect = { 0, 0, 0, 65535, 65535, 0, 0, 0, 65535, 65535 };
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expect.data(), seen.data(), expect.size());
+}
+
+void test_loop_order(void)
+{
+    using namespace script;
+    // Light LED_ORDER[0..2] one per frame, then LED_ORDER[1] off
+    std::vector<uint8_t> code = { LOOP, 3, SET, ORDER, 0xff, 0xff, WAIT, 1, END, SET, ORDER | 1, 0, 0, WAIT, 255 };
+    auto vm = load(code);
+    for (auto f = 0; f < 3; f++) {
+        vm.frame();
+        TEST_ASSERT_EQUAL(65535, vm.value[LED_ORDER[f]]);
+    }
+    vm.frame();
+    // Out of the loop, ORDER is relative to 0 again
+    TEST_ASSERT_EQUAL(0, vm.value[LED_ORDER[1]]);
+    TEST_ASSERT_EQUAL(65535, vm.value[LED_ORDER[2]]);
+}
+
+void test_nested_loops(void)
+{
+    using namespace script;
+    // 3 x 4 frames, then a marker
+    std::vector<uint8_t> code = { LOOP, 3, LOOP, 4, WAIT, 1, END, END, SET, 0, 1, 0, WAIT, 255 };
+    auto vm = load(code);
+    for (auto f = 0; f < 12; f++) {
+        vm.frame();
+        TEST_ASSERT_EQUAL(0, vm.value[0]);
+    }
+    vm.frame();
+    TEST_ASSERT_EQUAL(1, vm.value[0]);
+}
+
+void test_pick(void)
+{
+    using namespace script;
+    std::vector<uint8_t> code = { SET, ALL, 0, 0, PICK, 14, SET, PICKED, 0xff, 0xff, WAIT, 1 };
+    auto vm = load(code);
+    for (auto f = 0; f < 100; f++) {
+        vm.frame();
+        // Exactly one lit, the one picked
+        TEST_ASSERT_EQUAL(65535, vm.value[LED_ORDER[vm.picked]]);
+        TEST_ASSERT_EQUAL(65535, std::accumulate(vm.value.begin(), vm.value.end(), 0U));
+    }
+}
+
+void test_runaway(void)
+{
+    using namespace script;
+    // A loop that never waits still gives up the frame
+    std::vector<uint8_t> code = { LOOP, 0, RAMP, ALL, 0xff, 0xff, 100, END };
+    auto vm = load(code);
+    vm.frame();
+    vm.frame();
+    TEST_ASSERT_GREATER_THAN(0, vm.value[0]);
+}
+
+void test_effect(void)
+{
+    using namespace script;
+    static constexpr uint8_t a[] = { SET, ALL, 1, 0, WAIT, 255 };
+    static constexpr uint8_t b[] = { SET, ALL, 2, 0, WAIT, 1, SET, ALL, 3, 0, WAIT, 255 };
+    Script<sim_t> sa(a), sb(b);
+    sim_t mbi;
+    sb(mbi, 0);
+    sb(mbi, 1);
+    TEST_ASSERT_EQUAL(3, mbi.buffer[0]);
+    sa(mbi, 2);
+    TEST_ASSERT_EQUAL(1, mbi.buffer[0]);
+    // Switching scripts starts them from the top
+    sb(mbi, 3);
+    TEST_ASSERT_EQUAL(2, mbi.buffer[0]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_ramp);
+    RUN_TEST(test_wait_and_restart);
+    RUN_TEST(test_loop_order);
+    RUN_TEST(test_nested_loops);
+    RUN_TEST(test_pick);
+    RUN_TEST(test_runaway);
+    RUN_TEST(test_effect);
+    return UNITY_END();
+}
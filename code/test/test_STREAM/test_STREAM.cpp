@@ -0,0 +1,174 @@
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <unity.h>
+
+#include "Stream.h"
+
+constexpr uint8_t N = 11;
+using decoder_t = StreamDecoder<N>;
+using encoder_t = StreamEncoder<N>;
+using frame_t = encoder_t::frame_t;
+
+// A few LEDs fading at different rates, like a typical effect
+frame_t make_frame(const uint32_t n)
+{
+    frame_t f {};
+    for (auto i = 0U; i < N; i += 3)
+        f[i] = n * (i + 1) * 97;
+    return f;
+}
+
+std::vector<uint8_t> encode(encoder_t& enc, const frame_t& f)
+{
+    encoder_t::packet_t pkt;
+    auto len = enc.encode(f, pkt);
+    return std::vector<uint8_t>(pkt.begin(), pkt.begin() + len);
+}
+
+void test_key_and_delta(void)
+{
+    encoder_t enc;
+    decoder_t dec;
+    size_t key_len = 0, delta_len = 0;
+    for (uint32_t n = 0; n < 2; n++) {
+        auto pkt = encode(enc, make_frame(n));
+        (n ? delta_len : key_len) = pkt.size();
+        for (auto i = 0U; i < pkt.size(); i++)
+            TEST_ASSERT_EQUAL(i == pkt.size() - 1, dec.feed(pkt[i]));
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(make_frame(n).data(), dec.frame().data(), N);
+    }
+    TEST_ASSERT_EQUAL(1 + 1 + 2 * N + 2, key_len);
+    TEST_ASSERT_LESS_THAN(key_len, delta_len);
+    // Must fit comfortably in 115200 baud at 60fps
+    TEST_ASSERT_LESS_THAN(115200 / 10 / 60, key_len);
+}
+
+void test_corruption(void)
+{
+    encoder_t enc;
+    decoder_t dec;
+    uint32_t good = 0;
+    for (uint32_t n = 0; n < encoder_t::KEY_INTERVAL * 2; n++) {
+        auto pkt = encode(enc, make_frame(n));
+        // Flip a bit in the second frame, so the deltas after it have nothing to apply to
+        if (n == 1)
+            pkt[3] ^= 0x10;
+        for (auto b : pkt)
+            good += dec.feed(b);
+        if (n >= 1 && n < encoder_t::KEY_INTERVAL)
+            TEST_ASSERT_EQUAL_UINT16_ARRAY(make_frame(0).data(), dec.frame().data(), N);
+    }
+    TEST_ASSERT_EQUAL(1, dec.errors);
+    TEST_ASSERT_EQUAL(1 + encoder_t::KEY_INTERVAL, good);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(make_frame(encoder_t::KEY_INTERVAL * 2 - 1).data(), dec.frame().data(), N);
+}
+
+void test_resync(void)
+{
+    encoder_t enc;
+    decoder_t dec;
+    // Start listening half way through a packet, with junk (including SYNC) on the line
+    auto pkt = encode(enc, make_frame(1));
+    std::vector<uint8_t> line = { 0x00, stream::SYNC, 0x13, stream::SYNC, stream::SYNC };
+    line.insert(line.end(), pkt.begin() + pkt.size() / 2, pkt.end());
+    pkt = encode(enc, make_frame(2));
+    line.insert(line.end(), pkt.begin(), pkt.end());
+    for (auto b : line)
+        dec.feed(b);
+    // The delta that follows is ignored, but the next key frame gets us going again
+    for (uint32_t n = 3; n < encoder_t::KEY_INTERVAL + 2; n++)
+        for (auto b : encode(enc, make_frame(n)))
+            dec.feed(b);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(make_frame(encoder_t::KEY_INTERVAL + 1).data(), dec.frame().data(), N);
+}
+
+void test_cal(void)
+{
+    encoder_t enc;
+    decoder_t dec;
+    encoder_t::cal_t cal;
+    for (auto i = 0U; i < N; i++)
+        cal[i] = { static_cast<uint16_t>(0xffff - i * 1000), static_cast<uint16_t>(i * 7) };
+    encoder_t::packet_t pkt;
+    auto len = encoder_t::encode_cal(cal, pkt);
+    TEST_ASSERT_EQUAL(stream::max_packet(N), len);
+
+    // A table isn't a frame, and is handed over once
+    for (auto b : encode(enc, make_frame(1)))
+        dec.feed(b);
+    for (auto i = 0U; i < len; i++)
+        TEST_ASSERT_FALSE(dec.feed(pkt[i]));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(make_frame(1).data(), dec.frame().data(), N);
+    auto got = dec.take_cal();
+    TEST_ASSERT(got != nullptr);
+    for (auto i = 0U; i < N; i++) {
+        TEST_ASSERT_EQUAL(cal[i].gain, (*got)[i].gain);
+        TEST_ASSERT_EQUAL(cal[i].offset, (*got)[i].offset);
+    }
+    TEST_ASSERT(dec.take_cal() == nullptr);
+
+    // A corrupt one is dropped
+    pkt[5] ^= 1;
+    for (auto i = 0U; i < len; i++)
+        dec.feed(pkt[i]);
+    TEST_ASSERT(dec.take_cal() == nullptr);
+    TEST_ASSERT_EQUAL(1, dec.errors);
+}
+
+// Send frames through a pty as stream_send would to a serial port, decode them on the other side
+void test_pty_loopback(void)
+{
+    int master, slave;
+    TEST_ASSERT_EQUAL(0, openpty(&master, &slave, nullptr, nullptr, nullptr));
+    termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    constexpr uint32_t FRAMES = 600;
+    std::thread sender([master]() {
+        encoder_t enc;
+        encoder_t::packet_t pkt;
+        for (uint32_t n = 0; n < FRAMES; n++) {
+            auto len = enc.encode(make_frame(n), pkt);
+            for (size_t done = 0; done < len;)
+                done += write(master, pkt.data() + done, len - done);
+        }
+    });
+
+    decoder_t dec;
+    uint32_t frames = 0;
+    uint8_t buf[64];
+    while (frames < FRAMES) {
+        auto len = read(slave, buf, sizeof(buf));
+        TEST_ASSERT_GREATER_THAN(0, len);
+        for (auto i = 0; i < len; i++) {
+            if (dec.feed(buf[i])) {
+                TEST_ASSERT_EQUAL_UINT16_ARRAY(make_frame(frames).data(), dec.frame().data(), N);
+                frames++;
+            }
+        }
+    }
+    sender.join();
+    close(slave);
+    close(master);
+    TEST_ASSERT_EQUAL(0, dec.errors);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_key_and_delta);
+    RUN_TEST(test_corruption);
+    RUN_TEST(test_resync);
+    RUN_TEST(test_cal);
+    RUN_TEST(test_pty_loopback);
+    return UNITY_END();
+}
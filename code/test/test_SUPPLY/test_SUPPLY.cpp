@@ -0,0 +1,115 @@
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+#include <unity.h>
+
+#include "SupplyGovernor.h"
+
+// Supply voltage (hours, mV) over a full discharge of the cells at ~5mA. Flat while the regulator has headroom, then
+// tracks the cells down the knee at the end of life.
+constexpr std::array<std::pair<float, uint16_t>, 14> DISCHARGE = { {
+    { 0, 3300 },
+    { 30, 3300 },
+    { 36, 3290 },
+    { 40, 3260 },
+    { 42, 3220 },
+    { 43, 3195 },
+    { 44, 3170 },
+    { 45, 3120 },
+    { 46, 3060 },
+    { 47, 2990 },
+    { 48, 2900 },
+    { 49, 2750 },
+    { 50, 2500 },
+    { 51, 2200 },
+} };
+
+constexpr float SAMPLE_HOURS = SUPPLY_SAMPLE_FRAMES / float(FPS) / 3600;
+
+uint16_t supply_at(float hours)
+{
+    for (auto i = 1U; i < DISCHARGE.size(); i++) {
+        auto [h0, v0] = DISCHARGE[i - 1];
+        auto [h1, v1] = DISCHARGE[i];
+        if (hours < h1)
+            return v0 + (hours - h0) / (h1 - h0) * (v1 - v0);
+    }
+    return DISCHARGE.back().second;
+}
+
+// Deterministic load noise: LED current transients pull the supply around a bit sample to sample
+int16_t noise(uint32_t i, int16_t amplitude)
+{
+    i = i * 2654435761U;
+    return static_cast<int16_t>((i >> 16) % (2 * amplitude + 1)) - amplitude;
+}
+
+// Run the whole curve, returns number of level changes and checks they only ever step down
+uint32_t run_discharge(int16_t noise_mv)
+{
+    SupplyGovernor gov;
+    uint32_t changes = 0, i = 0;
+    for (float h = 0; h < DISCHARGE.back().first; h += SAMPLE_HOURS, i++) {
+        auto prev = gov.level;
+        gov.update(supply_at(h) + noise(i, noise_mv));
+        if (gov.level != prev) {
+            std::cout << "  " << h << "h: " << gov.supply_mv() << "mV, level " << int(prev) << " -> "
+                      << int(gov.level) << "\n";
+            TEST_ASSERT_GREATER_THAN(prev, gov.level);
+            changes++;
+        }
+    }
+    TEST_ASSERT_EQUAL(SupplyGovernor::LEVELS.size() - 1, gov.level);
+    return changes;
+}
+
+void test_discharge_clean(void) { TEST_ASSERT_EQUAL(SUPPLY_LEVELS_MV.size(), run_discharge(0)); }
+
+void test_discharge_noisy(void)
+{
+    // Noise bigger than the hysteresis margin is smoothed out
+    TEST_ASSERT_EQUAL(SUPPLY_LEVELS_MV.size(), run_discharge(SUPPLY_HYSTERESIS_MV * 3 / 2));
+}
+
+void test_hysteresis(void)
+{
+    SupplyGovernor gov;
+
+    auto settle = [&gov](uint16_t mv) {
+        for (auto i = 0; i < 32; i++)
+            gov.update(mv);
+    };
+
+    settle(3300);
+    TEST_ASSERT_EQUAL(0, gov.level);
+    settle(SUPPLY_LEVELS_MV[0] - 1);
+    TEST_ASSERT_EQUAL(1, gov.level);
+    // Cells recover a little when the load drops, not enough to step back up
+    settle(SUPPLY_LEVELS_MV[0] + SUPPLY_HYSTERESIS_MV - 1);
+    TEST_ASSERT_EQUAL(1, gov.level);
+    settle(SUPPLY_LEVELS_MV[0] + SUPPLY_HYSTERESIS_MV);
+    TEST_ASSERT_EQUAL(0, gov.level);
+    // Sudden collapse steps straight down to the bottom
+    settle(2000);
+    TEST_ASSERT_EQUAL(SupplyGovernor::LEVELS.size() - 1, gov.level);
+}
+
+void test_first_sample(void)
+{
+    SupplyGovernor gov;
+    gov.update(3300);
+    TEST_ASSERT_EQUAL(3300, gov.supply_mv());
+    TEST_ASSERT_EQUAL(0, gov.level);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_discharge_clean);
+    RUN_TEST(test_discharge_noisy);
+    RUN_TEST(test_hysteresis);
+    RUN_TEST(test_first_sample);
+    return UNITY_END();
+}
@@ -0,0 +1,221 @@
+// Compile animation scripts (scripts/*.anim) to bytecode for the Script effect (see include/Script.h).
+//
+// Syntax, one statement per line, # starts a comment:
+//   set <led> <value>            set immediately
+//   ramp <led> <value> <frames>  ramp linearly to value over frames (1-255)
+//   wait <frames>                show this many frames (1-255) before carrying on
+//   loop [count]                 repeat up to the matching end count times (1-255), or for ever
+//   end
+//   pick <n>                     pick a random number 0..n-1 for `pick` LEDs
+// <led> is an LED number, `all`, `order[+-k]` (LED_ORDER[innermost loop iteration + k]) or `pick[+-k]`
+// (LED_ORDER[last pick + k]). <value> is 0-65535, a percentage like `50%`, or `max`.
+//
+// Build & run from the code/ directory:
+//   g++ -std=c++17 -O2 -Iinclude -Ilib/rng tools/animc.cpp lib/rng/rng.cpp -o animc
+//   ./animc scripts/*.anim > include/Scripts.h
+// Each script's size and the interpreter's time per frame running it (on this PC) are reported on stderr.
+//
+// Or simulate one script, printing a frame per line (the input format of stream_send, to preview it on the card):
+//   ./animc --sim 600 scripts/comet.anim | ./stream_send /dev/ttyUSB0
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SimMBI.h"
+
+#include "Script.h"
+
+using sim_t = SimMBI<NUM_LEDS>;
+
+struct error {
+    std::string msg;
+};
+
+long number(const std::string& s, const long lo, const long hi)
+{
+    char* end;
+    long v = std::strtol(s.c_str(), &end, 0);
+    if (s.empty() || *end || v < lo || v > hi)
+        throw error { "expected a number " + std::to_string(lo) + "-" + std::to_string(hi) + ", got '" + s + "'" };
+    return v;
+}
+
+uint8_t led(const std::string& s)
+{
+    if (s == "all")
+        return script::ALL;
+    for (auto [name, mode] : { std::pair { "order", script::ORDER }, std::pair { "pick", script::PICKED } }) {
+        std::string n(name);
+        if (s.compare(0, n.size(), n) == 0) {
+            long ofs = s.size() > n.size() ? number(s.substr(n.size()), -63, 63) : 0;
+            // Offsets wrap around LED_ORDER anyway, keep them positive
+            long size = LED_ORDER.size();
+            return mode | static_cast<uint8_t>(((ofs % size) + size) % size);
+        }
+    }
+    return number(s, 0, NUM_LEDS - 1);
+}
+
+uint16_t value(const std::string& s)
+{
+    if (s == "max")
+        return sim_t::LED_MAX;
+    if (!s.empty() && s.back() == '%')
+        return number(s.substr(0, s.size() - 1), 0, 100) * sim_t::LED_MAX / 100;
+    return number(s, 0, sim_t::LED_MAX);
+}
+
+std::vector<uint8_t> compile(std::istream& in)
+{
+    std::vector<uint8_t> code;
+    std::string line;
+    int depth = 0;
+    auto emit16 = [&](uint16_t v) {
+        code.push_back(v & 0xff);
+        code.push_back(v >> 8);
+    };
+
+    for (int n = 1; std::getline(in, line); n++) {
+        try {
+            line = line.substr(0, line.find('#'));
+            std::istringstream ss(line);
+            std::vector<std::string> words;
+            for (std::string w; ss >> w;)
+                words.push_back(w);
+            if (words.empty())
+                continue;
+
+            auto& op = words[0];
+            auto want = [&](size_t args) {
+                if (words.size() != args + 1)
+                    throw error { op + " takes " + std::to_string(args) + " argument(s)" };
+            };
+            if (op == "set") {
+                want(2);
+                code.push_back(script::SET);
+                code.push_back(led(words[1]));
+                emit16(value(words[2]));
+            } else if (op == "ramp") {
+                want(3);
+                code.push_back(script::RAMP);
+                code.push_back(led(words[1]));
+                emit16(value(words[2]));
+                code.push_back(number(words[3], 1, 255));
+            } else if (op == "wait") {
+                want(1);
+                code.push_back(script::WAIT);
+                code.push_back(number(words[1], 1, 255));
+            } else if (op == "loop") {
+                if (words.size() > 2)
+                    want(1);
+                if (++depth > script::MAX_DEPTH)
+                    throw error { "loops nested too deep" };
+                code.push_back(script::LOOP);
+                code.push_back(words.size() > 1 ? number(words[1], 1, 255) : 0);
+            } else if (op == "end") {
+                want(0);
+                if (--depth < 0)
+                    throw error { "end without loop" };
+                code.push_back(script::END);
+            } else if (op == "pick") {
+                want(1);
+                code.push_back(script::PICK);
+                code.push_back(number(words[1], 1, 255));
+            } else {
+                throw error { "unknown statement '" + op + "'" };
+            }
+        } catch (error& e) {
+            throw error { "line " + std::to_string(n) + ": " + e.msg };
+        }
+    }
+    if (depth)
+        throw error { "loop without end" };
+    if (code.empty())
+        throw error { "empty script" };
+    return code;
+}
+
+// Run a script for some frames against a simulated driver, returns host time per frame in ns
+template <class F> double simulate(const std::vector<uint8_t>& code, const uint32_t frames, F each)
+{
+    sim_t mbi;
+    ScriptVM<NUM_LEDS> vm;
+    vm.load(code.data(), code.size());
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t f = 0; f < frames; f++) {
+        vm.frame();
+        mbi.get_buffer() = vm.value;
+        each(mbi.buffer);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+std::string basename(const std::string& path)
+{
+    auto name = path.substr(path.find_last_of('/') + 1);
+    return name.substr(0, name.find('.'));
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> files(argv + 1, argv + argc);
+    uint32_t sim_frames = 0;
+    if (files.size() >= 2 && files[0] == "--sim") {
+        sim_frames = number(files[1], 1, INT32_MAX);
+        files.erase(files.begin(), files.begin() + 2);
+    }
+    if (files.empty() || (sim_frames && files.size() != 1)) {
+        std::cerr << "usage: " << argv[0] << " script.anim... > Scripts.h\n"
+                  << "       " << argv[0] << " --sim <frames> script.anim\n";
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> compiled;
+    for (auto& f : files) {
+        std::ifstream in(f);
+        if (!in) {
+            std::cerr << f << ": can't open\n";
+            return 1;
+        }
+        try {
+            compiled.emplace_back(basename(f), compile(in));
+        } catch (error& e) {
+            std::cerr << f << ": " << e.msg << "\n";
+            return 1;
+        }
+    }
+
+    if (sim_frames) {
+        simulate(compiled[0].second, sim_frames, [](auto& fb) {
+            for (auto i = 0U; i < fb.size(); i++)
+                std::cout << fb[i] << (i + 1 < fb.size() ? ' ' : '\n');
+        });
+        return 0;
+    }
+
+    printf("#pragma once\n\n"
+           "// Generated by tools/animc.cpp from scripts/, don't edit. To regenerate, from the code/ directory:\n"
+           "//   ./animc scripts/*.anim > include/Scripts.h\n\n"
+           "#include <cstdint>\n\n"
+           "namespace scripts {\n");
+    fprintf(stderr, "%-12s %6s %12s\n", "script", "bytes", "ns/frame");
+    size_t total = 0;
+    for (auto& [name, code] : compiled) {
+        auto ns = simulate(code, 1 << 20, [](auto& fb) { asm volatile("" : : "r"(fb.data()) : "memory"); });
+        fprintf(stderr, "%-12s %6zu %12.1f\n", name.c_str(), code.size(), ns);
+        total += code.size();
+
+        printf("constexpr uint8_t %s[] = {", name.c_str());
+        for (auto i = 0U; i < code.size(); i++)
+            printf("%s%d,", i % 16 ? " " : "\n    ", code[i]);
+        printf("\n};\n");
+    }
+    printf("}\n");
+    fprintf(stderr, "%-12s %6zu\n", "total", total);
+}
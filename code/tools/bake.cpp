@@ -0,0 +1,197 @@
+// Bake deterministic, periodic effects into flash tables for the Baked effect (see include/Baked.h).
+//
+// Each effect below is run against a simulated driver until it settles, one period is captured and compressed, and
+// the playback is checked against the original. The tables are written to stdout as a header; the flash each costs
+// and how long the original and baked versions take per frame (on this PC, as a rough guide to the saving on target)
+// are reported on stderr.
+//
+// Build & run from the code/ directory:
+//   g++ -std=c++17 -O2 -Iinclude -Ilib/rng tools/bake.cpp lib/rng/rng.cpp -o bake
+//   ./bake > include/BakedTables.h
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "SimMBI.h"
+
+#include "Baked.h"
+#include "Effects.h"
+
+using sim_t = SimMBI<NUM_LEDS>;
+using frame_t = sim_t::fb_t;
+using effect_t = MBIEffect<sim_t>;
+using chase_t = Chase<sim_t, decltype(LED_ORDER)::const_iterator>;
+
+struct bake_t {
+    const char* name;
+    std::function<std::unique_ptr<effect_t>()> make;
+};
+
+// Same parameters as the instances in EffectSetup.h
+const bake_t BAKES[] = {
+    { "ChaseAround", [] { return std::make_unique<chase_t>(LED_ORDER.begin(), LED_ORDER.end(), 120, 3); } },
+    { "ChaseBack",
+        [] { return std::make_unique<chase_t>(LED_ORDER.begin(), LED_ORDER.end(), 15, sim_t::N_LEDS, chase_t::DOWN); } },
+    { "FastChase", [] { return std::make_unique<chase_t>(LED_ORDER.begin(), LED_ORDER.end(), 5, 1, chase_t::DOWN); } },
+    { "RampAllUp", [] { return std::make_unique<RampAll<sim_t>>(sim_t::LED_MAX / 128); } },
+};
+
+// Frames to let an effect settle before capturing (e.g. chase tails fading in from an all-off buffer)
+constexpr uint32_t WARMUP = 4096;
+// Longest period we look for. A ramp by an odd step takes 65536 frames to come around.
+constexpr uint32_t MAX_PERIOD = 65536;
+constexpr uint32_t MAX_RUN = UINT16_MAX;
+
+std::vector<frame_t> capture(effect_t& effect, const uint32_t n)
+{
+    sim_t mbi;
+    std::vector<frame_t> frames;
+    for (uint32_t f = 0; f < n; f++) {
+        effect(mbi, f);
+        frames.push_back(mbi.buffer);
+    }
+    return frames;
+}
+
+// Smallest period the captured frames repeat with after the warmup, 0 if none
+uint32_t find_period(const std::vector<frame_t>& frames)
+{
+    for (uint32_t p = 1; p <= MAX_PERIOD; p++) {
+        bool match = true;
+        for (uint32_t t = 0; match && t < p; t++)
+            match = frames[WARMUP + t] == frames[WARMUP + p + t];
+        if (match)
+            return p;
+    }
+    return 0;
+}
+
+struct table_t {
+    frame_t first;
+    std::vector<int16_t> palette;
+    std::vector<uint8_t> runs;
+    uint16_t n_runs = 0;
+
+    size_t bytes() const { return sizeof(first) + palette.size() * 2 + runs.size() + sizeof(BakedTable); }
+};
+
+bool compress(const std::vector<frame_t>& frames, const uint32_t period, table_t& table)
+{
+    table.first = frames[WARMUP];
+    std::map<int16_t, uint8_t> index;
+    std::array<uint8_t, NUM_LEDS> cur {}, prev {};
+    uint32_t run = 0;
+
+    auto flush = [&]() {
+        table.runs.push_back(run & 0xff);
+        table.runs.push_back(run >> 8);
+        for (auto i = 0U; i < NUM_LEDS; i += 2)
+            table.runs.push_back(prev[i] | (i + 1 < NUM_LEDS ? prev[i + 1] << 4 : 0));
+        table.n_runs++;
+        run = 0;
+    };
+
+    for (uint32_t t = 0; t < period; t++) {
+        auto& a = frames[WARMUP + t];
+        auto& b = frames[WARMUP + t + 1];
+        for (auto i = 0U; i < NUM_LEDS; i++) {
+            int16_t d = static_cast<uint16_t>(b[i] - a[i]);
+            if (!index.count(d)) {
+                if (table.palette.size() == 16)
+                    return false;
+                index[d] = table.palette.size();
+                table.palette.push_back(d);
+            }
+            cur[i] = index[d];
+        }
+        if (run && (cur != prev || run == MAX_RUN))
+            flush();
+        prev = cur;
+        run++;
+    }
+    flush();
+    return true;
+}
+
+// Play the table back for two periods, it must match the original exactly
+bool verify(const BakedTable& table, const std::vector<frame_t>& frames, const uint32_t period)
+{
+    sim_t mbi;
+    Baked<sim_t> baked(table);
+    for (uint32_t t = 0; t < period * 2; t++) {
+        baked(mbi, t);
+        if (mbi.buffer != frames[WARMUP + t])
+            return false;
+    }
+    return true;
+}
+
+// Host time per frame in ns
+double time_per_frame(effect_t& effect)
+{
+    constexpr uint32_t N = 1 << 20;
+    sim_t mbi;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t f = 0; f < N; f++) {
+        effect(mbi, f);
+        asm volatile("" : : "r"(mbi.buffer.data()) : "memory");
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+}
+
+template <class T> void print_array(const char* type, const char* name, const char* suffix, const T& values)
+{
+    printf("constexpr %s %s_%s[] = {", type, name, suffix);
+    for (auto i = 0U; i < values.size(); i++)
+        printf("%s%d,", i % 16 ? " " : "\n    ", static_cast<int>(values[i]));
+    printf("\n};\n");
+}
+
+int main()
+{
+    printf("#pragma once\n\n"
+           "// Generated by tools/bake.cpp, don't edit. To regenerate, from the code/ directory:\n"
+           "//   ./bake > include/BakedTables.h\n\n"
+           "#include <cstdint>\n\n"
+           "#include \"Baked.h\"\n\n"
+           "namespace baked {\n");
+    fprintf(stderr, "%-12s %8s %6s %8s %12s %12s\n", "effect", "period", "runs", "bytes", "orig ns/fr", "baked ns/fr");
+
+    int ret = 0;
+    for (auto& b : BAKES) {
+        auto effect = b.make();
+        auto frames = capture(*effect, WARMUP + 2 * MAX_PERIOD);
+        auto period = find_period(frames);
+        table_t table;
+        if (!period || !compress(frames, period, table)) {
+            fprintf(stderr, "%s: %s\n", b.name, period ? "more than 16 distinct steps" : "no period found");
+            ret = 1;
+            continue;
+        }
+        BakedTable baked { NUM_LEDS, table.first.data(), table.palette.data(), table.runs.data(), table.n_runs };
+        if (!verify(baked, frames, period)) {
+            fprintf(stderr, "%s: playback doesn't match\n", b.name);
+            ret = 1;
+            continue;
+        }
+
+        auto orig_ns = time_per_frame(*b.make());
+        Baked<sim_t> player(baked);
+        auto baked_ns = time_per_frame(player);
+        fprintf(stderr, "%-12s %8u %6u %8zu %12.1f %12.1f\n", b.name, period, table.n_runs, table.bytes(), orig_ns,
+            baked_ns);
+
+        printf("\n// %s: %u frame period in %u runs, %zu bytes\n", b.name, period, table.n_runs, table.bytes());
+        print_array("uint16_t", b.name, "first", table.first);
+        print_array("int16_t", b.name, "palette", table.palette);
+        print_array("uint8_t", b.name, "runs", table.runs);
+        printf("constexpr BakedTable %s = { %u, %s_first, %s_palette, %s_runs, %u };\n", b.name, NUM_LEDS, b.name,
+            b.name, b.name, table.n_runs);
+    }
+    printf("}\n");
+    return ret;
+}
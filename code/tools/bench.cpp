@@ -0,0 +1,252 @@
+// Time the output stage, every effect and the RNG on the PC, so performance changes show up as numbers between commits
+// rather than in comments. Host timings aren't M0 cycles (the PC has a divider and an FPU, for a start), but the
+// rankings and any big regression carry over.
+//
+// Results are written to stdout as CSV, one benchmark per line: name, ns per call (the median of several passes) and
+// noise (the spread of the middle half of the passes, as a percentage of the median). Keep the output of a baseline
+// build and compare against it; --compare prints the change for each benchmark and fails if any got slower by more
+// than --threshold percent (default 15) plus the noise in both runs. On a busy PC the noise can reach tens of percent,
+// and only regressions bigger than that are caught, so run them on a quiet machine.
+//
+// --m0 prints OpCount's estimates instead (see test/test_OPCOUNT/opcount_run.h): M0 cycles, divisions and RNG draws per
+// call of the effects that divide or draw. These don't depend on the PC, so they're the same every run.
+//
+// Build & run from the code/ directory. -Os and no vectorizing, like the firmware:
+//   g++ -std=c++17 -Os -fno-tree-vectorize -Iinclude -Ilib/rng tools/bench.cpp lib/rng/rng.cpp -o bench
+//   ./bench > before.csv
+//   ./bench --compare before.csv
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "OutputStage.h"
+
+#include "../test/test_GOLDEN/golden_run.h"
+#include "../test/test_OPCOUNT/opcount_run.h"
+
+// Each benchmark runs for at least this long per pass. The median of PASSES passes is taken, and the passes go round
+// every benchmark in turn so that a stretch of load on the PC lands in one pass of each rather than all of one.
+constexpr double MIN_RUN_NS = 20e6;
+constexpr uint8_t PASSES = 9;
+
+struct timing_t {
+    double ns; // Per call
+    double noise_pct; // Spread of the middle half of the passes
+};
+
+// Benchmarks own their state, as they're called again on every pass
+struct bench_t {
+    std::string name;
+    std::function<void(uint32_t)> f;
+    uint32_t iters;
+    std::array<double, PASSES> runs;
+
+    double run() const
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iters; i++)
+            f(i);
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    timing_t timing() const
+    {
+        auto sorted = runs;
+        std::sort(sorted.begin(), sorted.end());
+        const double median = sorted[PASSES / 2];
+        return { median / iters, (sorted[PASSES * 3 / 4] - sorted[PASSES / 4]) / median * 100 };
+    }
+};
+std::vector<bench_t> benches;
+
+// Keep the compiler from optimizing a result away
+template <class T> void sink(const T& v) { asm volatile("" : : "r"(v) : "memory"); }
+
+void bench(const std::string& name, std::function<void(uint32_t)> f) { benches.push_back({ name, std::move(f), 1024, {} }); }
+
+void run_benches()
+{
+    for (auto& b : benches) {
+        while (b.run() < MIN_RUN_NS)
+            b.iters *= 2;
+    }
+    for (auto pass = 0U; pass < PASSES; pass++) {
+        for (auto& b : benches)
+            b.runs[pass] = b.run();
+    }
+}
+
+template <class px_t> void bench_correction(const char* depth)
+{
+    auto stage = std::make_shared<Stage<px_t>>(GOLDEN_BRIGHT);
+    // Spread over the range, skipping 0 which returns straight away
+    auto val = [](uint32_t i) { return static_cast<px_t>((i * 2654435761U >> 16) | 1); };
+    auto name = std::string("correction/") + depth;
+    auto led = [](uint32_t i) { return static_cast<uint8_t>(i % NUM_LEDS); };
+    bench(name + "/gamma", [=](uint32_t i) { sink(stage->template apply_correction<true, 0, false>(val(i), led(i))); });
+    bench(name + "/linear", [=](uint32_t i) { sink(stage->template apply_correction<false, 0, false>(val(i), led(i))); });
+    bench(name + "/gamma_dither",
+        [=](uint32_t i) { sink(stage->template apply_correction<true, 8, false>(val(i), led(i))); });
+    bench(name + "/gamma_dither_cal",
+        [=](uint32_t i) { sink(stage->template apply_correction<true, 8, true>(val(i), led(i))); });
+}
+
+// put_frame() is correct_frame() and then shifting the words out over GPIO, which has no meaningful host equivalent
+void bench_output()
+{
+    auto mbi = std::make_shared<mbi_t>(GOLDEN_BRIGHT);
+    effect_rng = pcg();
+    AllRandom(*mbi, 0);
+    for (uint8_t shift : { 0, 2 }) {
+        auto name = std::string("output/correct_frame/shift") + std::to_string(shift);
+        bench(name, [=](uint32_t) {
+            if (mbi->keyframe_due())
+                mbi->push_keyframe(shift);
+            sink(mbi->correct_frame<ENABLE_GAMMA, ENABLE_DITHER, false>());
+        });
+        bench(name + "_cal", [=](uint32_t) {
+            if (mbi->keyframe_due())
+                mbi->push_keyframe(shift);
+            sink(mbi->correct_frame<ENABLE_GAMMA, ENABLE_DITHER, true>());
+        });
+    }
+}
+
+void bench_rng()
+{
+    effect_rng = pcg();
+    bench("rng/pcg", [](uint32_t) { sink(effect_rng()); });
+    // As drawn by StarBurst and set_effect(), and Twinkle's targets
+    std::uniform_int_distribution<uint8_t> led(0, NUM_LEDS - 1);
+    std::uniform_int_distribution<int16_t> val(-8192, 8192);
+    std::uniform_int_distribution<uint16_t> frames(10, 40);
+    bench("rng/uniform_uint8", [=](uint32_t) mutable { sink(led(effect_rng)); });
+    bench("rng/uniform_int16", [=](uint32_t) mutable { sink(val(effect_rng)); });
+    bench("rng/uniform_uint16", [=](uint32_t) mutable { sink(frames(effect_rng)); });
+}
+
+void bench_effects()
+{
+    for (auto& e : GOLDEN_EFFECTS) {
+        auto mbi = std::make_shared<mbi_t>(GOLDEN_BRIGHT);
+        auto& effect = e.effect;
+        bench(std::string("effect/") + e.name, [mbi, &effect](uint32_t f) {
+            effect(*mbi, f);
+            sink(mbi->cur_frame().data());
+        });
+    }
+}
+
+// Estimated M0 cycles per call of the effects test_OPCOUNT counts, the divisions and RNG draws in them
+void report_m0()
+{
+    auto report = [](const char* name, const opcount::counts_t& counts) {
+        auto per_call = [](const uint32_t n) { return static_cast<double>(n) / opcount::EFFECT_CALLS; };
+        printf("%s,%.0f,%.2f,%.2f\n", name, per_call(opcount::cycles(counts)), per_call(counts[opcount::DIV]),
+            per_call(counts[opcount::RNG]));
+    };
+    printf("name,m0_cycles,divs,draws\n");
+    report("effect/TwinkleTwinkle", opcount::twinkle_counts());
+    report("effect/ChaseRandom", opcount::random_chase_counts());
+    report("effect/Bursts", opcount::starburst_counts());
+    report("script/comet", opcount::script_counts(scripts::comet));
+    report("script/sparkle", opcount::script_counts(scripts::sparkle));
+}
+
+// Compare against an earlier run: a benchmark has regressed if it got slower by more than the threshold plus the noise
+// in both runs
+std::map<std::string, timing_t> baseline;
+double threshold = 15;
+
+double change_pct(const timing_t& before, const timing_t& after) { return (after.ns / before.ns - 1) * 100; }
+
+// Read an earlier run. Runs from before the noise column was added count as noiseless.
+bool load_baseline(const char* path)
+{
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "Can't read %s\n", path);
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        auto comma = line.find(',');
+        if (comma == std::string::npos || !line.compare(0, comma, "name"))
+            continue;
+        auto& b = baseline[line.substr(0, comma)];
+        char* end;
+        b.ns = std::strtod(line.c_str() + comma + 1, &end);
+        b.noise_pct = *end == ',' ? std::atof(end + 1) : 0;
+    }
+    return true;
+}
+
+// Compare against the baseline, returns whether nothing regressed
+bool compare()
+{
+    bool ok = true;
+    printf("name,before_ns,after_ns,change_pct,noise_pct\n");
+    for (auto& bench : benches) {
+        const auto name = bench.name.c_str();
+        const auto timing = bench.timing();
+        auto b = baseline.find(bench.name);
+        if (b == baseline.end()) {
+            printf("%s,,%.2f,,%.1f\n", name, timing.ns, timing.noise_pct);
+            continue;
+        }
+        const double change = change_pct(b->second, timing);
+        const double noise = b->second.noise_pct + timing.noise_pct;
+        printf("%s,%.2f,%.2f,%+.1f,%.1f\n", name, b->second.ns, timing.ns, change, noise);
+        if (change > threshold + noise) {
+            fprintf(stderr, "%s is %.1f%% slower (noise %.1f%%)\n", name, change, noise);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    const char* baseline_path = nullptr;
+    for (auto i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--compare") && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (!strcmp(argv[i], "--threshold") && i + 1 < argc) {
+            threshold = std::atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--m0")) {
+            report_m0();
+            return 0;
+        } else {
+            fprintf(stderr, "Usage: %s [--m0 | --compare before.csv [--threshold percent]]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    bench_correction<uint16_t>("16bit");
+    bench_correction<uint8_t>("8bit");
+    bench_output();
+    bench_rng();
+    bench_effects();
+    run_benches();
+
+    if (baseline_path)
+        return load_baseline(baseline_path) && compare() ? 0 : 1;
+
+    printf("name,ns,noise_pct\n");
+    for (auto& bench : benches) {
+        const auto timing = bench.timing();
+        printf("%s,%.2f,%.1f\n", bench.name.c_str(), timing.ns, timing.noise_pct);
+    }
+    return 0;
+}
@@ -0,0 +1,33 @@
+// Record the golden frames the golden frame test (test/test_GOLDEN) checks effects against. Run it after a change that
+// is meant to change what the LEDs show, and commit the new goldens with it.
+//
+// Build & run from the code/ directory:
+//   g++ -std=c++17 -O2 -Iinclude -Ilib/rng tools/golden.cpp lib/rng/rng.cpp -o golden
+//   ./golden > test/test_GOLDEN/golden.h
+
+#include <cstdio>
+
+#include "../test/test_GOLDEN/golden_run.h"
+
+int main()
+{
+    printf("// Generated by tools/golden.cpp, don't edit. To update after changing what the effects show, from code/:\n"
+           "//   g++ -std=c++17 -O2 -Iinclude -Ilib/rng tools/golden.cpp lib/rng/rng.cpp -o golden\n"
+           "//   ./golden > test/test_GOLDEN/golden.h\n\n"
+           "#pragma once\n\n"
+           "#include \"golden_run.h\"\n\n"
+           "const golden_t GOLDEN[] = {\n");
+    for (auto& e : GOLDEN_EFFECTS) {
+        auto g = golden_run(e);
+        printf("    { \"%s\", 0x%08x, 0x%08x,\n        { {\n", g.name, g.draw_hash, g.out_hash);
+        for (auto& c : g.checks) {
+            printf("            {");
+            for (auto i = 0U; i < c.size(); i++)
+                printf("%s%u", i ? ", " : " ", c[i]);
+            printf(" },\n");
+        }
+        printf("        } } },\n");
+        fprintf(stderr, "%-20s draw %08x out %08x\n", g.name, g.draw_hash, g.out_hash);
+    }
+    printf("};\n");
+}
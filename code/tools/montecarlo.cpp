@@ -0,0 +1,371 @@
+// Simulate thousands of power-on sessions of the card, to see what the effects lineup and brightness levels cost in
+// battery life. The effects are random, so what one run of one effect draws says little; this runs many sessions, each
+// from its own seed with its own button timeline: a starting effect and brightness, the effect changed every so often
+// and the brightness now and then, until the user turns it off or auto power off does. Simulated time runs as fast as
+// the PC can go, spread over every core.
+//
+// Each session runs the firmware's effects lineup (EffectSetup.h) through the output stage on the main loop's schedule,
+// like test/test_GOLDEN, with the driver's dark gating, and charges every frame to PowerModel. The report is CSV
+// tables:
+//   sessions     projected run time on fresh cells at each session's average current, percentiles across sessions
+//   brightness   average current and run time at each brightness level
+//   effects      the same for each effect in the lineup, plus the spread of its per-frame cost (draw and output
+//                correction, PC ns) and the frames over budget
+// The supply governor isn't modelled (the cells are always fresh), nor the menus' overlays.
+//
+// Frame costs are PC time, so the budget they're checked against (--budget-ns) is the frame period scaled down by how
+// much faster a PC runs this code than the M0. Integer effects run ~100x faster, float maths several thousand times:
+// treat overruns as a ranking, the DEBUG cycle reports on the card have the real cycles. The PC's scheduler adds
+// outliers to max_ns and the overruns too; p99 is the steadier figure.
+//
+// Workers are forked processes rather than threads, as the effects and their RNG are globals, as on the card. Each
+// session is forked again from its worker, so it starts from the effects as they were made, like the card at power on:
+// what a session draws doesn't depend on the sessions run before it, so the results (all but the PC timings) are the
+// same whatever --jobs is. --check runs the sessions on one worker and on --jobs workers and fails if they differ.
+//
+// Build & run from the code/ directory:
+//   g++ -std=c++17 -O2 -Iinclude -Ilib/rng tools/montecarlo.cpp lib/rng/rng.cpp -o montecarlo
+//   ./montecarlo [--sessions 1000] [--jobs N] [--seed 1] [--budget-ns 1666] [--check]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "PowerModel.h"
+
+#include "../test/test_GOLDEN/golden_run.h"
+
+// Brightness levels, cur_bright in main.cpp
+constexpr uint8_t N_BRIGHT = 7;
+constexpr uint8_t DEFAULT_BRIGHT = 6;
+constexpr uint16_t bright_scale(const uint8_t b) { return (1U << (b + 9)) - 1; } // as apply_brightness()
+
+// Session timeline. Sessions last until turned off (exponentially distributed) or auto power off. The effect is
+// changed and the brightness set to a random level at exponentially distributed intervals.
+constexpr double MEAN_SESSION_FRAMES = FPS * 60 * 30;
+constexpr double MEAN_EFFECT_FRAMES = FPS * 60 * 5;
+constexpr double MEAN_BRIGHT_FRAMES = FPS * 60 * 20;
+
+// How much faster the PC runs effect code than the M0, for the default budget
+constexpr uint32_t HOST_SPEEDUP = 100;
+constexpr uint32_t FRAME_NS = 1000000000 / FPS;
+
+// Per-frame cost histogram, in COST_BUCKET_NS buckets, the last one catching everything over
+constexpr uint32_t COST_BUCKET_NS = 50;
+constexpr uint32_t COST_BUCKETS = 2000;
+
+constexpr auto N_EFFECTS = effects.size();
+
+// Accumulated over sessions. Plain data, so sessions can add to it in memory shared with the main process.
+struct stats_t {
+    // Frames shown and their charge (uA * frames) for each effect at each brightness
+    uint64_t frames[N_EFFECTS][N_BRIGHT];
+    uint64_t charge[N_EFFECTS][N_BRIGHT];
+    uint32_t cost[N_EFFECTS][COST_BUCKETS];
+    uint64_t overruns[N_EFFECTS];
+    uint32_t max_ns[N_EFFECTS];
+
+    void add(const stats_t& o)
+    {
+        for (auto e = 0U; e < N_EFFECTS; e++) {
+            for (auto b = 0U; b < N_BRIGHT; b++) {
+                frames[e][b] += o.frames[e][b];
+                charge[e][b] += o.charge[e][b];
+            }
+            for (auto c = 0U; c < COST_BUCKETS; c++)
+                cost[e][c] += o.cost[e][c];
+            overruns[e] += o.overruns[e];
+            max_ns[e] = std::max(max_ns[e], o.max_ns[e]);
+        }
+    }
+};
+
+struct session_t {
+    uint32_t frames;
+    uint32_t average_ua;
+
+    bool operator==(const session_t& o) const { return frames == o.frames && average_ua == o.average_ua; }
+};
+
+// A pcg seeded from a session seed and a stream number
+pcg seeded(const uint32_t seed, const uint32_t stream)
+{
+    uint32_t s = seed * 2654435761U ^ stream;
+    return pcg([&] { return s = s * 1664525U + 1013904223U; });
+}
+
+session_t run_session(const uint32_t seed, const uint32_t budget_ns, stats_t& st)
+{
+    auto timeline = seeded(seed, 0);
+    effect_rng = seeded(seed, 1);
+    std::exponential_distribution<double> length(1 / MEAN_SESSION_FRAMES), effect_gap(1 / MEAN_EFFECT_FRAMES),
+        bright_gap(1 / MEAN_BRIGHT_FRAMES);
+    std::uniform_int_distribution<uint8_t> pick_effect(0, N_EFFECTS - 1), pick_bright(0, N_BRIGHT - 1);
+
+    auto frames = static_cast<uint32_t>(std::min<double>(length(timeline), APO_FRAMES)) + 1;
+    uint8_t cur_effect = pick_effect(timeline);
+    uint8_t bright = pick_bright(timeline);
+    auto next_effect = static_cast<uint32_t>(effect_gap(timeline));
+    auto next_bright = static_cast<uint32_t>(bright_gap(timeline));
+
+    mbi_t mbi(bright_scale(bright));
+    mbi.output_limit = PowerModel::max_out_sum(CURRENT_LIMIT_UA);
+    mbi.clear_buffers();
+    PowerModel power;
+
+    bool frame_drawn = true;
+    uint8_t keyframe_shift = 0;
+    uint16_t dark_frames = 0;
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        // The button timeline, as press_main() and the brightness menu
+        if (frame >= next_effect) {
+            cur_effect = (cur_effect + 1) % N_EFFECTS;
+            mbi.clear_buffers();
+            next_effect = frame + static_cast<uint32_t>(effect_gap(timeline)) + 1;
+        }
+        if (frame >= next_bright) {
+            bright = pick_bright(timeline);
+            mbi.bright = bright_scale(bright);
+            next_bright = frame + static_cast<uint32_t>(bright_gap(timeline)) + 1;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        // mainloop()
+        auto& effect = effects[cur_effect].get();
+        if (frame_drawn) {
+            keyframe_shift = effect.frame_shift = effect.keyframe_shift();
+            effect(mbi, frame);
+            frame_drawn = false;
+        }
+        // sys_tick_handler()
+        if (!frame_drawn && mbi.keyframe_due()) {
+            mbi.push_keyframe(keyframe_shift);
+            frame_drawn = true;
+        }
+        if (!mbi.keyframe_due())
+            mbi.correct_frame<ENABLE_GAMMA, ENABLE_DITHER>();
+        auto ns = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start)
+                                            .count());
+
+        // The driver is switched off after MBI_DARK_FRAMES dark frames (see MBI5043::put_frame)
+        dark_frames = mbi.output_sum() ? 0 : std::min<uint16_t>(dark_frames + 1, MBI_DARK_FRAMES);
+        bool powered = !(MBI_DARK_FRAMES && MBI_DARK_POWER_OFF && dark_frames >= MBI_DARK_FRAMES);
+        auto before = power.charge;
+        power.update(mbi.output_sum(), powered);
+
+        st.frames[cur_effect][bright]++;
+        st.charge[cur_effect][bright] += power.charge - before;
+        st.cost[cur_effect][std::min(ns / COST_BUCKET_NS, COST_BUCKETS - 1)]++;
+        st.max_ns[cur_effect] = std::max(st.max_ns[cur_effect], ns);
+        st.overruns[cur_effect] += ns > budget_ns;
+    }
+    return { frames, power.average_ua() };
+}
+
+// Hours on fresh cells at an average current
+double run_hours(const double ua) { return ua ? BATTERY_CAPACITY_MAH * 1000.0 / ua : 0; }
+
+// ns at the p'th percentile of a cost histogram
+uint32_t cost_percentile(const uint32_t (&cost)[COST_BUCKETS], const double p)
+{
+    uint64_t total = 0;
+    for (auto c : cost)
+        total += c;
+    uint64_t seen = 0;
+    for (auto i = 0U; i < COST_BUCKETS; i++) {
+        seen += cost[i];
+        if (seen && seen >= p / 100 * total)
+            return (i + 1) * COST_BUCKET_NS;
+    }
+    return COST_BUCKETS * COST_BUCKET_NS;
+}
+
+const char* effect_name(const uint8_t e)
+{
+    for (auto& g : GOLDEN_EFFECTS) {
+        if (&g.effect == &effects[e].get())
+            return g.name;
+    }
+    return "?";
+}
+
+void report(const stats_t& st, std::vector<session_t>& sessions, const double wall_s)
+{
+    uint64_t total_frames = 0;
+    for (auto& s : sessions)
+        total_frames += s.frames;
+    double sim_hours = static_cast<double>(total_frames) / (FPS * 3600);
+    printf("sessions,simulated_hours,wall_s,speedup\n");
+    printf("%zu,%.1f,%.1f,%.0f\n\n", sessions.size(), sim_hours, wall_s, sim_hours * 3600 / wall_s);
+
+    // Higher current, shorter run time: the 5th percentile of run time is the 95th of current
+    std::sort(sessions.begin(), sessions.end(),
+        [](const session_t& a, const session_t& b) { return a.average_ua > b.average_ua; });
+    auto at = [&](const double p) { return sessions[static_cast<size_t>(p / 100 * (sessions.size() - 1))]; };
+    printf("run_time_percentile,average_ua,run_hours\n");
+    for (auto p : { 5, 25, 50, 75, 95 })
+        printf("%d,%u,%.1f\n", p, at(p).average_ua, run_hours(at(p).average_ua));
+    printf("\n");
+
+    printf("brightness,frames_pct,average_ua,run_hours\n");
+    for (auto b = 0U; b < N_BRIGHT; b++) {
+        uint64_t frames = 0, charge = 0;
+        for (auto e = 0U; e < N_EFFECTS; e++) {
+            frames += st.frames[e][b];
+            charge += st.charge[e][b];
+        }
+        double ua = frames ? static_cast<double>(charge) / frames : 0;
+        printf("%u,%.1f,%.0f,%.1f\n", b, 100.0 * frames / total_frames, ua, run_hours(ua));
+    }
+    printf("\n");
+
+    printf("effect,frames_pct,average_ua,run_hours,default_bright_ua,p50_ns,p99_ns,max_ns,overruns\n");
+    for (auto e = 0U; e < N_EFFECTS; e++) {
+        uint64_t frames = 0, charge = 0;
+        for (auto b = 0U; b < N_BRIGHT; b++) {
+            frames += st.frames[e][b];
+            charge += st.charge[e][b];
+        }
+        double ua = frames ? static_cast<double>(charge) / frames : 0;
+        auto def_frames = st.frames[e][DEFAULT_BRIGHT];
+        double def_ua = def_frames ? static_cast<double>(st.charge[e][DEFAULT_BRIGHT]) / def_frames : 0;
+        printf("%s,%.1f,%.0f,%.1f,%.0f,%u,%u,%u,%llu\n", effect_name(e), 100.0 * frames / total_frames, ua,
+            run_hours(ua), def_ua, cost_percentile(st.cost[e], 50), cost_percentile(st.cost[e], 99), st.max_ns[e],
+            static_cast<unsigned long long>(st.overruns[e]));
+    }
+}
+
+// Zeroed memory the forked workers and sessions write their results to, seen by the main process
+template <class T> T* shared(const size_t n)
+{
+    auto p = mmap(nullptr, n * sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    return static_cast<T*>(p);
+}
+
+// Fork, run f() in the child and wait for it, returns whether it exited cleanly
+template <class F> bool forked(F f)
+{
+    auto pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        f();
+        _exit(0);
+    }
+    int status;
+    return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Run sessions seed, seed + 1, ... on `jobs` workers, worker w taking sessions w, w + jobs, ... Each session runs in a
+// process of its own forked from the worker, which hasn't drawn anything. Returns false if any of them failed.
+bool simulate(const uint32_t n_sessions, const uint32_t seed, const uint32_t budget_ns, const uint32_t jobs,
+    stats_t& total, std::vector<session_t>& sessions)
+{
+    auto results = shared<session_t>(n_sessions);
+    auto worker_stats = shared<stats_t>(jobs);
+    std::vector<pid_t> workers;
+    for (auto w = 0U; w < jobs; w++) {
+        auto pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return false;
+        }
+        if (pid == 0) {
+            for (auto s = w; s < n_sessions; s += jobs) {
+                if (!forked([&] { results[s] = run_session(seed + s, budget_ns, worker_stats[w]); }))
+                    _exit(1);
+            }
+            _exit(0);
+        }
+        workers.push_back(pid);
+    }
+
+    bool ok = true;
+    for (auto pid : workers) {
+        int status;
+        ok &= waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    total = {};
+    for (auto w = 0U; w < jobs; w++)
+        total.add(worker_stats[w]);
+    sessions.assign(results, results + n_sessions);
+    munmap(results, n_sessions * sizeof(session_t));
+    munmap(worker_stats, jobs * sizeof(stats_t));
+    return ok;
+}
+
+// Whether two runs got the same results, leaving out the PC timings
+bool same_results(const stats_t& a, const std::vector<session_t>& a_sessions, const stats_t& b,
+    const std::vector<session_t>& b_sessions)
+{
+    return a_sessions == b_sessions && !memcmp(a.frames, b.frames, sizeof(a.frames))
+        && !memcmp(a.charge, b.charge, sizeof(a.charge));
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t n_sessions = 1000, seed = 1, budget_ns = FRAME_NS / HOST_SPEEDUP;
+    uint32_t jobs = std::max(1U, std::thread::hardware_concurrency());
+    bool check = false;
+    for (auto i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--sessions") && i + 1 < argc) {
+            n_sessions = std::strtoul(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--jobs") && i + 1 < argc) {
+            jobs = std::max(1UL, std::strtoul(argv[++i], nullptr, 0));
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = std::strtoul(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--budget-ns") && i + 1 < argc) {
+            budget_ns = std::strtoul(argv[++i], nullptr, 0);
+        } else if (!strcmp(argv[i], "--check")) {
+            check = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--sessions n] [--jobs n] [--seed n] [--budget-ns ns] [--check]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!n_sessions)
+        return 2;
+    jobs = std::min(jobs, n_sessions);
+
+    auto start = std::chrono::steady_clock::now();
+    auto total = new stats_t;
+    std::vector<session_t> sessions;
+    if (!simulate(n_sessions, seed, budget_ns, jobs, *total, sessions)) {
+        fprintf(stderr, "A worker failed\n");
+        return 1;
+    }
+
+    if (check) {
+        // Against a single worker, or two if that's what was asked for
+        auto other_jobs = jobs > 1 ? 1 : std::min(2U, n_sessions);
+        auto other = new stats_t;
+        std::vector<session_t> other_sessions;
+        if (!simulate(n_sessions, seed, budget_ns, other_jobs, *other, other_sessions)) {
+            fprintf(stderr, "A worker failed\n");
+            return 1;
+        }
+        bool same = same_results(*total, sessions, *other, other_sessions);
+        printf("%u sessions on %u and %u jobs: %s\n", n_sessions, jobs, other_jobs, same ? "same" : "DIFFERENT");
+        return same ? 0 : 1;
+    }
+
+    report(*total, sessions, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return 0;
+}
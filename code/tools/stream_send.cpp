@@ -0,0 +1,128 @@
+// Stream frames to the card over its UART (see include/Stream.h).
+//
+// Frames are read from stdin, one per line, as NUM_LEDS whitespace separated values 0-65535, and sent at a fixed rate.
+// If stdin is a terminal or empty, a test pattern is sent instead.
+//
+// With --cal, a calibration table is sent instead, to try out before putting it in LED_CAL (config.h): one line per
+// LED, its gain and offset. It lasts until the card powers off.
+//
+// Build & run from the code/ directory:
+//   g++ -std=c++17 -O2 -Iinclude tools/stream_send.cpp -o stream_send
+//   ./stream_send /dev/ttyUSB0 [fps] < frames.txt
+//   ./stream_send /dev/ttyUSB0 --cal < cal.txt
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "Stream.h"
+#include "config.h"
+
+using encoder_t = StreamEncoder<NUM_LEDS>;
+
+// Open a serial port raw at UART_SPEED (works on a pty too)
+static int serial_open(const char* path)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0)
+        return fd;
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B115200);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    static_assert(UART_SPEED == 115200, "update the termios speed");
+    return fd;
+}
+
+// A dot running around the LEDs, fading as it goes
+static encoder_t::frame_t test_pattern(const uint32_t n)
+{
+    encoder_t::frame_t f {};
+    for (auto i = 0U; i < f.size(); i++) {
+        auto dist = (n / 4 + f.size() - i) % f.size();
+        f[i] = dist < 4 ? 65535 >> (dist * 4) : 0;
+    }
+    return f;
+}
+
+// Send one calibration table read from stdin
+static int send_cal(const int fd)
+{
+    encoder_t::cal_t cal;
+    for (auto& c : cal) {
+        if (!(std::cin >> c.gain >> c.offset)) {
+            std::cerr << "Need a gain and offset for each of the " << NUM_LEDS << " LEDs\n";
+            return 1;
+        }
+    }
+    encoder_t::packet_t pkt;
+    auto len = encoder_t::encode_cal(cal, pkt);
+    if (write(fd, pkt.data(), len) != static_cast<ssize_t>(len)) {
+        std::perror("write");
+        return 1;
+    }
+    tcdrain(fd);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <serial device> [fps | --cal] < frames\n";
+        return 1;
+    }
+    int fd = serial_open(argv[1]);
+    if (fd < 0) {
+        std::perror(argv[1]);
+        return 1;
+    }
+    if (argc > 2 && std::string(argv[2]) == "--cal")
+        return send_cal(fd);
+    uint32_t fps = argc > 2 ? std::atoi(argv[2]) : FPS;
+
+    encoder_t enc;
+    encoder_t::packet_t pkt;
+    std::string line;
+    bool from_stdin = !isatty(STDIN_FILENO) && std::cin.peek() != EOF;
+    auto period = std::chrono::microseconds(1000000 / fps);
+    auto next = std::chrono::steady_clock::now();
+    size_t bytes = 0;
+
+    for (uint32_t n = 0;; n++) {
+        encoder_t::frame_t f {};
+        if (from_stdin) {
+            if (!std::getline(std::cin, line))
+                break;
+            std::istringstream ss(line);
+            for (auto& v : f)
+                ss >> v;
+        } else {
+            f = test_pattern(n);
+        }
+
+        auto len = enc.encode(f, pkt);
+        if (write(fd, pkt.data(), len) != static_cast<ssize_t>(len)) {
+            std::perror("write");
+            return 1;
+        }
+        bytes += len;
+        if (n % fps == fps - 1)
+            std::cerr << "\r" << n + 1 << " frames, " << bytes / (n + 1) << " bytes/frame avg" << std::flush;
+
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+    std::cerr << "\n";
+    close(fd);
+}
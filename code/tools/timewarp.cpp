@@ -0,0 +1,60 @@
+// Run button scenarios through the main loop on virtual frames (see test/test_MAINLOOP/timewarp.h for the format), so
+// hours of menus and auto power off play out in a fraction of a second. Prints each scenario's unmet expectations and
+// when it powered off, and fails if any expectation wasn't met.
+//
+// Build & run from the code/ directory:
+//   g++ -std=c++17 -O2 -Iinclude -Ilib/rng tools/timewarp.cpp lib/rng/rng.cpp -o timewarp
+//   ./timewarp [--effect n] scenario.txt...
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "../test/test_MAINLOOP/timewarp.h"
+
+int main(int argc, char** argv)
+{
+    uint8_t effect = 0;
+    bool ok = true, any = false;
+    for (auto i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--effect") && i + 1 < argc) {
+            effect = std::strtoul(argv[++i], nullptr, 0);
+            continue;
+        }
+        std::ifstream in(argv[i]);
+        if (!in) {
+            fprintf(stderr, "Can't read %s\n", argv[i]);
+            return 2;
+        }
+        std::stringstream text;
+        text << in.rdbuf();
+        std::vector<timewarp_step_t> steps;
+        if (auto bad = parse_scenario(text.str(), steps)) {
+            fprintf(stderr, "%s:%u: can't parse\n", argv[i], bad);
+            return 2;
+        }
+        any = true;
+
+        auto start = std::chrono::steady_clock::now();
+        Timewarp tw(effect);
+        auto failures = tw.run(steps);
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        for (auto& f : failures)
+            printf("%s: %s\n", argv[i], f.c_str());
+        printf("%s: %s after %u frames (%.1fh) in %.0fms", argv[i], failures.empty() ? "passed" : "FAILED", tw.frame,
+            static_cast<double>(tw.frame) / (FPS * 3600), ms);
+        if (tw.off_frame)
+            printf(", powered off at frame %u", tw.off_frame);
+        printf("\n");
+        ok &= failures.empty();
+    }
+    if (!any) {
+        fprintf(stderr, "Usage: %s [--effect n] scenario.txt...\n", argv[0]);
+        return 2;
+    }
+    return ok ? 0 : 1;
+}